@@ -1,10 +1,25 @@
 #include "AppRequests.h"
+#include "GlucoseWorker.h"
+#include "WorkQueue.h"
+#include "PowerLedger.h"
+#include "Profiler.h"
+#include "Log.h"
 #include <time.h>
 
 // Settings keys (must match TextWatch.c and package.json)
 #define INVERT_KEY 0
 #define TEXT_ALIGN_KEY 1
 #define LANGUAGE_KEY 2
+#define ESTIMATE_KEY 3
+#define POWER_KEY 4
+
+// Persistent storage key for the last glucose reading (settings use 0-4);
+// written only while the worker, which keeps the history, is not running
+#define PERSIST_KEY_LAST_READING 100
+
+// Set once the worker was launched; launching on every start would prompt
+// the user each time another app's worker is active
+#define PERSIST_KEY_WORKER_LAUNCHED 103
 
 // Callback for receiving glucose data from phone
 static GlucoseDataCallback s_glucose_callback = NULL;
@@ -12,16 +27,65 @@ static GlucoseDataCallback s_glucose_callback = NULL;
 // Callback for receiving settings from phone
 static SettingsCallback s_settings_callback = NULL;
 
+// Callback for phone connection changes
+static ConnectionCallback s_connection_callback = NULL;
+
 // Stored glucose values (updated when received)
 static int s_glucose_value = 0;      // Default: no data
 static int s_trend_value = -1;       // Default: unknown trend (-1)
 static time_t s_last_glucose_timestamp = 0;  // Unix time of last valid data
 static time_t s_last_request_timestamp = 0;  // Unix time of last request sent
-static const time_t GLUCOSE_STALE_SECONDS = 15 * 60;  // Consider data stale after 15 minutes
 static const time_t GLUCOSE_REQUEST_THROTTLE_SECONDS = 60;  // 1 minute between requests (reduced for better reliability)
 static bool s_initialized = false;
 static bool s_last_request_failed = false;  // Track if last request failed
 
+// Connection tracking; a single catch-up request follows each reconnect
+static bool s_connected = false;
+static AppTimer *s_catch_up_timer = NULL;
+
+// Reported with every request so the phone can skip sending unchanged settings
+static uint32_t s_settings_hash = 0;
+static const uint32_t CATCH_UP_DELAY_MS = 2000;  // Let the phone app settle after reconnecting
+
+// All followed patients from the last KEY_PATIENTS message (kept in RAM only;
+// the next reading brings them back after a relaunch)
+static PatientReading s_patients[MAX_PATIENTS];
+static int s_patient_count = 0;
+
+// Freshness of the primary reading: when it arrived, and once drawn how old
+// it was on screen; reported with the next request
+static time_t s_received_s = 0;
+static uint16_t s_received_ms = 0;
+static bool s_display_pending = false;
+static bool s_freshness_pending = false;
+static int32_t s_display_age_s = 0;
+static uint16_t s_display_delay_ms = 0;
+static DataAgeStats s_data_age;
+
+// Previous distinct reading, to measure the slope between readings
+static int s_previous_glucose_value = 0;
+static time_t s_previous_glucose_timestamp = 0;
+
+// Power profile factor on the request interval
+static int s_request_scale = 1;
+
+// Trend projection between readings
+static bool s_estimation_enabled = false;
+static const time_t ESTIMATE_MIN_SECONDS = 90;         // Younger readings are shown as they are
+static const int ESTIMATE_MAX_ERROR = 15;               // mg/dL; show the reading when less certain
+static const time_t SLOPE_MIN_SECONDS = 3 * 60;         // Readings closer than this give a noisy slope
+static const time_t SLOPE_MAX_SECONDS = 20 * 60;        // Readings further apart describe an old trend
+static const int SLOPE_MAX_X10 = 40;                    // Clamp measured slopes to 4 mg/dL per minute
+static const int SLOPE_ERROR_X10 = 5;                   // Uncertainty of a measured slope per minute
+
+// Rate of change for each trend arrow in tenths of mg/dL per minute (middle
+// of each LibreLinkUp arrow range) and its uncertainty, indexed by trend - 1
+static const int8_t TREND_RATE_X10[] = { -25, -15, 0, 15, 25 };
+static const int8_t TREND_RATE_ERROR_X10[] = { 10, 5, 10, 5, 10 };
+
+#define GLUCOSE_REQUEST_INTERVAL_MINUTES 5
+#define GLUCOSE_ESTIMATING_REQUEST_INTERVAL_MINUTES 10
+
 // Forward declaration for AppSync callback compatibility
 static AppMessageInboxReceived s_original_inbox_handler = NULL;
 
@@ -40,15 +104,151 @@ static bool glucose_data_stale(void) {
   return (now - s_last_glucose_timestamp) > GLUCOSE_STALE_SECONDS;
 }
 
+static StoredReading current_reading(void) {
+  StoredReading reading = {
+    .timestamp = (int32_t)s_last_glucose_timestamp,
+    .value = (int16_t)s_glucose_value,
+    .trend = (int8_t)s_trend_value
+  };
+  return reading;
+}
+
+// Save the current reading so the next launch can show it on the first frame
+static void persist_last_reading(void) {
+  StoredReading reading = current_reading();
+  persist_write_data(PERSIST_KEY_LAST_READING, &reading, sizeof(reading));
+  power_ledger_count(LEDGER_PERSIST_WRITES, 1);
+}
+
+// Hand a new reading to the background worker, which appends it to the
+// shared history (one flash write)
+static void forward_reading_to_worker(void) {
+  StoredReading reading = current_reading();
+  AppWorkerMessage message;
+  worker_message_pack(&message, &reading);
+  app_worker_send_message(WORKER_MSG_READING, &message);
+  power_ledger_count(LEDGER_PERSIST_WRITES, 1);
+}
+
+// Launch the worker the first time only; after that it runs until the user
+// picks another app's worker
+static void start_worker(void) {
+  if (app_worker_is_running() || persist_exists(PERSIST_KEY_WORKER_LAUNCHED)) {
+    return;
+  }
+  AppWorkerResult result = app_worker_launch();
+  LOG_DEBUG("Worker launch: %d", (int)result);
+  persist_write_bool(PERSIST_KEY_WORKER_LAUNCHED, true);
+  power_ledger_count(LEDGER_PERSIST_WRITES, 1);
+}
+
+// Deferred: persist the reading, through the worker while it runs
+static void save_reading_job(void *context) {
+  if (app_worker_is_running()) {
+    forward_reading_to_worker();
+  } else {
+    persist_last_reading();
+  }
+}
+
+// Restore the newest of the reading saved by persist_last_reading and the
+// worker's history; the history also gives the previous reading for the
+// slope estimate. Staleness is checked on read.
+static void restore_last_reading(void) {
+  StoredReading reading;
+  if (persist_read_data(PERSIST_KEY_LAST_READING, &reading, sizeof(reading)) == (int)sizeof(reading)) {
+    s_glucose_value = reading.value;
+    s_trend_value = reading.trend;
+    s_last_glucose_timestamp = (time_t)reading.timestamp;
+  }
+
+  ReadingHistory history;
+  if (persist_read_data(PERSIST_KEY_WORKER_HISTORY, &history, sizeof(history)) == (int)sizeof(history)
+      && history.count > 0 && history.count <= WORKER_HISTORY_SIZE) {
+    const StoredReading *latest = &history.readings[history.count - 1];
+    if ((time_t)latest->timestamp > s_last_glucose_timestamp) {
+      s_glucose_value = latest->value;
+      s_trend_value = latest->trend;
+      s_last_glucose_timestamp = (time_t)latest->timestamp;
+      if (history.count > 1) {
+        s_previous_glucose_value = history.readings[history.count - 2].value;
+        s_previous_glucose_timestamp = (time_t)history.readings[history.count - 2].timestamp;
+      }
+    }
+  }
+
+  if (s_last_glucose_timestamp != 0) {
+    LOG_DEBUG("Restored glucose reading: %d mg/dL, trend %d, %s",
+            s_glucose_value, s_trend_value, glucose_data_stale() ? "stale" : "fresh");
+  }
+}
+
+static uint32_t read_little_endian(const uint8_t *bytes, int length) {
+  uint32_t value = 0;
+  for (int i = length - 1; i >= 0; i--) {
+    value = (value << 8) | bytes[i];
+  }
+  return value;
+}
+
+// Unpack KEY_PATIENTS (layout in AppRequests.h); returns whether it was valid
+static bool unpack_patients(const uint8_t *data, uint16_t length) {
+  if (length < 1) {
+    return false;
+  }
+  int count = data[0];
+  if (count > MAX_PATIENTS || length < 1 + count * PATIENT_RECORD_SIZE) {
+    LOG_WARNING("Invalid patient list: %d patients in %u bytes", count, length);
+    return false;
+  }
+
+  for (int i = 0; i < count; i++) {
+    const uint8_t *record = data + 1 + i * PATIENT_RECORD_SIZE;
+    PatientReading *patient = &s_patients[i];
+    patient->value = (int16_t)read_little_endian(record, 2);
+    patient->trend = (int8_t)record[2];
+    patient->timestamp = (time_t)(int32_t)read_little_endian(record + 3, 4);
+    patient->initials[0] = (char)record[7];
+    patient->initials[1] = (char)record[8];
+    patient->initials[2] = '\0';
+  }
+  s_patient_count = count;
+  LOG_INFO("Readings of %d patients received", count);
+  return true;
+}
+
+// Timestamp of the reading we hold of each patient; patients update on their
+// own, so the phone compares them one by one
+static void write_patient_timestamps(DictionaryIterator *iter) {
+  uint8_t timestamps[MAX_PATIENTS * 4];
+  for (int i = 0; i < s_patient_count; i++) {
+    const uint32_t timestamp = (uint32_t)s_patients[i].timestamp;
+    for (int b = 0; b < 4; b++) {
+      timestamps[i * 4 + b] = (uint8_t)(timestamp >> (8 * b));
+    }
+  }
+  dict_write_data(iter, KEY_PATIENT_TIMESTAMPS, timestamps, s_patient_count * 4);
+}
+
 // Process glucose data from received message
 static void process_glucose_message(DictionaryIterator *iterator) {
+  // The phone has nothing newer than what we sent: no flash write, no redraw
+  if (dict_find(iterator, KEY_NOT_MODIFIED)) {
+    s_last_request_failed = false;
+    LOG_DEBUG("Glucose not modified since %ld", (long)s_last_glucose_timestamp);
+    return;
+  }
+
   bool data_updated = false;
+  const int previous_value = s_glucose_value;
+  const int previous_trend = s_trend_value;
+  const time_t previous_timestamp = s_last_glucose_timestamp;
   
   // Check for glucose value
   Tuple *glucose_tuple = dict_find(iterator, KEY_GLUCOSE_VALUE);
   if (glucose_tuple) {
     s_glucose_value = (int)glucose_tuple->value->int32;
-    APP_LOG(APP_LOG_LEVEL_INFO, "Glucose received: %d mg/dL", s_glucose_value);
+    LOG_INFO("Glucose received: %d mg/dL", s_glucose_value);
     data_updated = true;
   }
   
@@ -56,7 +256,7 @@ static void process_glucose_message(DictionaryIterator *iterator) {
   Tuple *trend_tuple = dict_find(iterator, KEY_TREND_VALUE);
   if (trend_tuple) {
     s_trend_value = (int)trend_tuple->value->int32;
-    APP_LOG(APP_LOG_LEVEL_INFO, "Trend received: %d", s_trend_value);
+    LOG_INFO("Trend received: %d", s_trend_value);
     data_updated = true;
   }
 
@@ -67,10 +267,37 @@ static void process_glucose_message(DictionaryIterator *iterator) {
   } else if (data_updated) {
     s_last_glucose_timestamp = time(NULL);
   }
+
+  // Remember the reading this one replaces for the slope estimate
+  if (data_updated && previous_timestamp != 0 && s_last_glucose_timestamp > previous_timestamp) {
+    s_previous_glucose_value = previous_value;
+    s_previous_glucose_timestamp = previous_timestamp;
+  }
+
+  // A reading without the patient list means the phone follows one patient
+  Tuple *patients_tuple = dict_find(iterator, KEY_PATIENTS);
+  if (patients_tuple && patients_tuple->type == TUPLE_BYTE_ARRAY) {
+    data_updated |= unpack_patients(patients_tuple->value->data, patients_tuple->length);
+  } else if (glucose_tuple) {
+    s_patient_count = 0;
+  }
   
   // Reset failed flag since we successfully received data
   if (data_updated) {
     s_last_request_failed = false;
+
+    // Only touch flash when the reading actually changed, and not while the
+    // message is being handled
+    if (s_glucose_value != previous_value || s_trend_value != previous_trend
+        || s_last_glucose_timestamp != previous_timestamp) {
+      work_queue_defer(save_reading_job, NULL);
+    }
+
+    // A new reading starts the receive-to-display stage
+    if (s_last_glucose_timestamp != previous_timestamp) {
+      time_ms(&s_received_s, &s_received_ms);
+      s_display_pending = true;
+    }
   }
   
   // Notify via callback if data was updated and callback is registered
@@ -89,7 +316,7 @@ static void process_settings_message(DictionaryIterator *iterator) {
   Tuple *align_tuple = dict_find(iterator, TEXT_ALIGN_KEY);
   if (align_tuple) {
     int value = (int)align_tuple->value->int32;
-    APP_LOG(APP_LOG_LEVEL_INFO, "Settings: TEXT_ALIGN=%d", value);
+    LOG_INFO("Settings: TEXT_ALIGN=%d", value);
     s_settings_callback(TEXT_ALIGN_KEY, value);
   }
 
@@ -97,7 +324,7 @@ static void process_settings_message(DictionaryIterator *iterator) {
   Tuple *invert_tuple = dict_find(iterator, INVERT_KEY);
   if (invert_tuple) {
     int value = (int)invert_tuple->value->int32;
-    APP_LOG(APP_LOG_LEVEL_INFO, "Settings: INVERT=%d", value);
+    LOG_INFO("Settings: INVERT=%d", value);
     s_settings_callback(INVERT_KEY, value);
   }
 
@@ -105,14 +332,52 @@ static void process_settings_message(DictionaryIterator *iterator) {
   Tuple *lang_tuple = dict_find(iterator, LANGUAGE_KEY);
   if (lang_tuple) {
     int value = (int)lang_tuple->value->int32;
-    APP_LOG(APP_LOG_LEVEL_INFO, "Settings: LANGUAGE=%d", value);
+    LOG_INFO("Settings: LANGUAGE=%d", value);
     s_settings_callback(LANGUAGE_KEY, value);
   }
+
+  // Check for ESTIMATE_KEY
+  Tuple *estimate_tuple = dict_find(iterator, ESTIMATE_KEY);
+  if (estimate_tuple) {
+    int value = (int)estimate_tuple->value->int32;
+    LOG_INFO("Settings: ESTIMATE=%d", value);
+    s_settings_callback(ESTIMATE_KEY, value);
+  }
+
+  // Check for POWER_KEY
+  Tuple *power_tuple = dict_find(iterator, POWER_KEY);
+  if (power_tuple) {
+    int value = (int)power_tuple->value->int32;
+    LOG_INFO("Settings: POWER=%d", value);
+    s_settings_callback(POWER_KEY, value);
+  }
+}
+
+// Deferred: answer a ledger request with the hourly counters
+static void send_ledger_job(void *context) {
+  uint8_t ledger[2 + LEDGER_HOURS * (4 + 2 * LEDGER_COUNTERS)];
+  const size_t length = power_ledger_serialize(ledger, sizeof(ledger));
+
+  DictionaryIterator *iter;
+  if (length == 0 || app_message_outbox_begin(&iter) != APP_MSG_OK) {
+    LOG_ERROR("Failed to send power ledger");
+    return;
+  }
+  dict_write_data(iter, KEY_LEDGER_DATA, ledger, length);
+  dict_write_end(iter);
+  app_message_outbox_send();
 }
 
 // Callback when message received - handles both glucose and config messages
 static void inbox_received_callback(DictionaryIterator *iterator, void *context) {
-  APP_LOG(APP_LOG_LEVEL_DEBUG, "Message received from phone");
+  PROFILE_SCOPE(PROFILE_INBOX);
+  LOG_DEBUG("Message received from phone");
+  power_ledger_count(LEDGER_INBOUND, 1);
+  power_ledger_count(LEDGER_INBOUND_BYTES, dict_size(iterator));
+
+  if (dict_find(iterator, KEY_LEDGER_REQUEST)) {
+    work_queue_defer(send_ledger_job, NULL);
+  }
   
   // Process glucose data from this message
   process_glucose_message(iterator);
@@ -125,10 +390,13 @@ static void inbox_received_callback(DictionaryIterator *iterator, void *context)
   if (s_original_inbox_handler) {
     s_original_inbox_handler(iterator, context);
   }
+
+  PROFILE_HEAP(HEAP_MESSAGE);
 }
 
 // Callback when inbox message dropped
 static void inbox_dropped_callback(AppMessageResult reason, void *context) {
+#if LOG_LEVEL >= LOG_LEVEL_WARNING
   const char *reason_str;
   switch (reason) {
     case APP_MSG_OK: reason_str = "OK"; break;
@@ -147,18 +415,19 @@ static void inbox_dropped_callback(AppMessageResult reason, void *context) {
     case APP_MSG_INTERNAL_ERROR: reason_str = "Internal error"; break;
     default: reason_str = "Unknown"; break;
   }
-  APP_LOG(APP_LOG_LEVEL_WARNING, "Message dropped: %s (%d)", reason_str, (int)reason);
+  LOG_WARNING("Message dropped: %s (%d)", reason_str, (int)reason);
+#endif
 }
 
 // Callback when message sent successfully
 static void outbox_sent_callback(DictionaryIterator *iterator, void *context) {
-  APP_LOG(APP_LOG_LEVEL_DEBUG, "Message sent successfully");
+  LOG_DEBUG("Message sent successfully");
 }
 
 // Callback when sending failed
 static void outbox_failed_callback(DictionaryIterator *iterator, 
                                    AppMessageResult reason, void *context) {
-  APP_LOG(APP_LOG_LEVEL_ERROR, "Message send failed: %d", (int)reason);
+  LOG_ERROR("Message send failed: %d", (int)reason);
 }
 
 // Register message callbacks and capture any existing inbox handler for forwarding
@@ -186,36 +455,237 @@ bool pebble_messenger_has_glucose_data(void) {
   return s_glucose_value > 0 && !glucose_data_stale();
 }
 
+int pebble_messenger_patient_count(void) {
+  return s_patient_count;
+}
+
+void pebble_messenger_get_patient(int index, PatientReading *patient) {
+  if (index < 0 || index >= s_patient_count) {
+    *patient = (PatientReading) { .value = 0, .trend = TREND_UNKNOWN };
+    return;
+  }
+
+  *patient = s_patients[index];
+  const time_t now = time(NULL);
+  if (now != (time_t)-1 && (now - patient->timestamp) > GLUCOSE_STALE_SECONDS) {
+    patient->value = 0;
+    patient->trend = TREND_UNKNOWN;
+  }
+}
+
+void pebble_messenger_set_estimation_enabled(bool enabled) {
+  s_estimation_enabled = enabled;
+}
+
+void pebble_messenger_set_request_scale(int scale) {
+  s_request_scale = scale > 0 ? scale : 1;
+}
+
+// Rate of change of the current reading in tenths of mg/dL per minute, and
+// its uncertainty. Prefers the slope between the last two readings over the
+// coarse trend arrow. Returns false if neither is known.
+static bool glucose_rate_x10(int *rate, int *error) {
+  const time_t span = s_last_glucose_timestamp - s_previous_glucose_timestamp;
+  if (s_previous_glucose_timestamp != 0 && span >= SLOPE_MIN_SECONDS && span <= SLOPE_MAX_SECONDS) {
+    int slope = (int)((s_glucose_value - s_previous_glucose_value) * 600 / span);
+    if (slope > SLOPE_MAX_X10) slope = SLOPE_MAX_X10;
+    if (slope < -SLOPE_MAX_X10) slope = -SLOPE_MAX_X10;
+    *rate = slope;
+    *error = SLOPE_ERROR_X10;
+    return true;
+  }
+
+  if (s_trend_value >= TREND_DOWN && s_trend_value <= TREND_UP) {
+    *rate = TREND_RATE_X10[s_trend_value - TREND_DOWN];
+    *error = TREND_RATE_ERROR_X10[s_trend_value - TREND_DOWN];
+    return true;
+  }
+  return false;
+}
+
+void pebble_messenger_get_estimate(GlucoseEstimate *estimate) {
+  estimate->error_bound = 0;
+  estimate->estimated = false;
+  pebble_messenger_get_glucose(&estimate->value, NULL);
+
+  if (!s_estimation_enabled || estimate->value <= 0) {
+    return;
+  }
+
+  const time_t age = time(NULL) - s_last_glucose_timestamp;
+  int rate, error;
+  if (age < ESTIMATE_MIN_SECONDS || !glucose_rate_x10(&rate, &error)) {
+    return;
+  }
+
+  // Rates are tenths of mg/dL per minute, age is in seconds
+  const int error_bound = (int)((error * age + 599) / 600);
+  if (error_bound > ESTIMATE_MAX_ERROR) {
+    return;
+  }
+
+  const int projected = s_glucose_value + (int)(rate * age / 600);
+  if (projected <= 0) {
+    return;
+  }
+
+  estimate->value = projected;
+  estimate->error_bound = error_bound;
+  estimate->estimated = true;
+}
+
+void pebble_messenger_reading_displayed(void) {
+  if (!s_display_pending) {
+    return;
+  }
+  s_display_pending = false;
+
+  time_t now_s;
+  uint16_t now_ms;
+  time_ms(&now_s, &now_ms);
+  const int32_t delay_ms = (int32_t)(now_s - s_received_s) * 1000 + now_ms - s_received_ms;
+  s_display_delay_ms = delay_ms > UINT16_MAX ? UINT16_MAX : (uint16_t)delay_ms;
+  s_display_age_s = (int32_t)(now_s - s_last_glucose_timestamp);
+  s_freshness_pending = true;
+
+  s_data_age.count++;
+  s_data_age.last_s = s_display_age_s;
+  s_data_age.total_s += s_display_age_s;
+  if (s_display_age_s > s_data_age.max_s) {
+    s_data_age.max_s = s_display_age_s;
+  }
+  LOG_DEBUG("Reading drawn %ld s after the sensor, %u ms after it arrived",
+            (long)s_display_age_s, s_display_delay_ms);
+}
+
+void pebble_messenger_get_data_age(DataAgeStats *stats) {
+  *stats = s_data_age;
+  stats->current_s = s_last_glucose_timestamp ? (int32_t)(time(NULL) - s_last_glucose_timestamp) : -1;
+}
+
+int pebble_messenger_request_interval_minutes(void) {
+  return s_request_scale *
+    (s_estimation_enabled ? GLUCOSE_ESTIMATING_REQUEST_INTERVAL_MINUTES : GLUCOSE_REQUEST_INTERVAL_MINUTES);
+}
+
+// Send a request message. It carries the timestamps of the readings we hold
+// so the phone answers with KEY_NOT_MODIFIED instead of repeating them
+static void send_glucose_request(void) {
+  DictionaryIterator *iter;
+  AppMessageResult result = app_message_outbox_begin(&iter);
+  
+  if (result != APP_MSG_OK) {
+    LOG_ERROR("Failed to begin message: %d", (int)result);
+    s_last_request_failed = true;
+    return;
+  }
+  
+  // Send request flag
+  dict_write_uint8(iter, KEY_REQUEST_DATA, 1);
+  if (s_last_glucose_timestamp != 0) {
+    dict_write_int32(iter, KEY_TIMESTAMP, (int32_t)s_last_glucose_timestamp);
+  }
+  if (s_patient_count > 1) {
+    write_patient_timestamps(iter);
+  }
+  dict_write_uint32(iter, KEY_SETTINGS_HASH, s_settings_hash);
+  dict_write_uint8(iter, KEY_REQUEST_INTERVAL, (uint8_t)pebble_messenger_request_interval_minutes());
+  if (s_freshness_pending) {
+    dict_write_int32(iter, KEY_DISPLAY_AGE, s_display_age_s);
+    dict_write_uint16(iter, KEY_DISPLAY_DELAY, s_display_delay_ms);
+  }
+  dict_write_end(iter);
+  
+  result = app_message_outbox_send();
+  if (result != APP_MSG_OK) {
+    LOG_ERROR("Failed to send request: %d", (int)result);
+    s_last_request_failed = true;
+  } else {
+    s_last_request_timestamp = time(NULL);
+    s_last_request_failed = false;
+    s_freshness_pending = false;
+    power_ledger_count(LEDGER_REQUESTS, 1);
+    LOG_DEBUG("Glucose data requested");
+  }
+}
+
+static void catch_up_timer_callback(void *context) {
+  s_catch_up_timer = NULL;
+  if (!s_connected) return;
+
+  // Bypasses the throttle: whatever we asked for before the drop was lost
+  LOG_DEBUG("Reconnected, requesting readings since %ld", (long)s_last_glucose_timestamp);
+  send_glucose_request();
+}
+
+static void connection_handler(bool connected) {
+  bool reconnected = connected && !s_connected;
+  s_connected = connected;
+
+  if (s_catch_up_timer) {
+    app_timer_cancel(s_catch_up_timer);
+    s_catch_up_timer = NULL;
+  }
+  if (reconnected) {
+    s_catch_up_timer = app_timer_register(CATCH_UP_DELAY_MS, catch_up_timer_callback, NULL);
+  }
+
+  if (s_connection_callback) {
+    s_connection_callback(connected);
+  }
+}
+
+void pebble_messenger_set_settings_hash(uint32_t hash) {
+  s_settings_hash = hash;
+}
+
+bool pebble_messenger_is_connected(void) {
+  return s_connected;
+}
+
 // Initialize message communication
 // Note: Call this BEFORE app_message_open() and AppSync init
-void pebble_messenger_init(GlucoseDataCallback glucose_callback, SettingsCallback settings_callback) {
+void pebble_messenger_init(GlucoseDataCallback glucose_callback, SettingsCallback settings_callback,
+                           ConnectionCallback connection_callback) {
   if (s_initialized) {
-    APP_LOG(APP_LOG_LEVEL_WARNING, "Messenger already initialized");
+    LOG_WARNING("Messenger already initialized");
     return;
   }
   
   s_glucose_callback = glucose_callback;
   s_settings_callback = settings_callback;
+  s_connection_callback = connection_callback;
   s_glucose_value = 0;
   s_trend_value = -1;
   s_last_glucose_timestamp = 0;
   s_last_request_timestamp = 0;
+
+  // Start from the last reading we had instead of "---"
+  restore_last_reading();
+  start_worker();
   
   // Register callbacks - may be overridden by AppSync later; can re-register after AppSync
   register_message_handlers();
+
+  // Only one subscriber is allowed per app, so the face gets the events
+  // through connection_callback
+  s_connected = connection_service_peek_pebble_app_connection();
+  connection_service_subscribe((ConnectionHandlers) {
+    .pebble_app_connection_handler = connection_handler
+  });
   
   s_initialized = true;
-  APP_LOG(APP_LOG_LEVEL_INFO, "Pebble Messenger initialized");
+  LOG_INFO("Pebble Messenger initialized");
 }
 
 // Allow re-registering after other components (e.g., AppSync) set their handlers
 void pebble_messenger_register_handlers(void) {
   if (!s_initialized) {
-    APP_LOG(APP_LOG_LEVEL_WARNING, "Messenger not initialized; cannot register handlers");
+    LOG_WARNING("Messenger not initialized; cannot register handlers");
     return;
   }
   register_message_handlers();
-  APP_LOG(APP_LOG_LEVEL_DEBUG, "Messenger handlers re-registered");
+  LOG_DEBUG("Messenger handlers re-registered");
 }
 
 // Open app message with appropriate buffer sizes
@@ -225,16 +695,18 @@ void pebble_messenger_open(uint32_t inbox_size, uint32_t outbox_size) {
   if (outbox_size < 128) outbox_size = 128;
   
   app_message_open(inbox_size, outbox_size);
-  APP_LOG(APP_LOG_LEVEL_DEBUG, "App message opened: inbox=%lu, outbox=%lu", 
+  LOG_DEBUG("App message opened: inbox=%lu, outbox=%lu", 
           (unsigned long)inbox_size, (unsigned long)outbox_size);
 }
 
 // Request glucose data from phone (sends a request message)
 void pebble_messenger_request_glucose(void) {
-  // Check Bluetooth connection first
-  if (!connection_service_peek_pebble_app_connection()) {
-    APP_LOG(APP_LOG_LEVEL_DEBUG, "Glucose request skipped: Bluetooth not connected");
-    s_last_request_failed = true;
+  // Suspended while disconnected; the reconnect sends its own catch-up request
+  if (!s_connected) {
+    return;
+  }
+  if (s_catch_up_timer) {
+    LOG_DEBUG("Glucose request skipped: catch-up request pending");
     return;
   }
   
@@ -245,45 +717,47 @@ void pebble_messenger_request_glucose(void) {
   
   if (now != (time_t)-1 && s_last_request_timestamp != 0) {
     if ((now - s_last_request_timestamp) < throttle_time) {
-      APP_LOG(APP_LOG_LEVEL_DEBUG, "Glucose request throttled (last request %ld seconds ago, throttle: %ld)", 
+      LOG_DEBUG("Glucose request throttled (last request %ld seconds ago, throttle: %ld)", 
               (long)(now - s_last_request_timestamp), (long)throttle_time);
       return;
     }
   }
   
-  DictionaryIterator *iter;
-  AppMessageResult result = app_message_outbox_begin(&iter);
-  
-  if (result != APP_MSG_OK) {
-    APP_LOG(APP_LOG_LEVEL_ERROR, "Failed to begin message: %d", (int)result);
-    s_last_request_failed = true;
-    return;
-  }
-  
-  // Send request flag
-  dict_write_uint8(iter, KEY_REQUEST_DATA, 1);
-  dict_write_end(iter);
-  
-  result = app_message_outbox_send();
-  if (result != APP_MSG_OK) {
-    APP_LOG(APP_LOG_LEVEL_ERROR, "Failed to send request: %d", (int)result);
-    s_last_request_failed = true;
-  } else {
-    s_last_request_timestamp = now;
-    s_last_request_failed = false;
-    APP_LOG(APP_LOG_LEVEL_DEBUG, "Glucose data requested");
+  send_glucose_request();
+}
+
+#if DEBUG
+void pebble_messenger_inject_glucose(int glucose_value, int trend_value) {
+  s_previous_glucose_value = s_glucose_value;
+  s_previous_glucose_timestamp = s_last_glucose_timestamp;
+  s_glucose_value = glucose_value;
+  s_trend_value = trend_value;
+  s_last_glucose_timestamp = time(NULL);
+  if (s_glucose_callback) {
+    s_glucose_callback(s_glucose_value, s_trend_value);
   }
 }
+#endif
 
 // Cleanup function
 void pebble_messenger_deinit(void) {
   if (!s_initialized) return;
   
+  // The worker keeps running while the face is closed; handle_deinit has
+  // flushed a reading still waiting in the work queue
+  connection_service_unsubscribe();
+  if (s_catch_up_timer) {
+    app_timer_cancel(s_catch_up_timer);
+    s_catch_up_timer = NULL;
+  }
+
   s_glucose_callback = NULL;
+  s_connection_callback = NULL;
   s_original_inbox_handler = NULL;
   s_last_request_timestamp = 0;
   s_last_glucose_timestamp = 0;
+  s_patient_count = 0;
   s_initialized = false;
   
-  APP_LOG(APP_LOG_LEVEL_DEBUG, "Pebble Messenger deinitialized");
+  LOG_DEBUG("Pebble Messenger deinitialized");
 }
@@ -8,6 +8,24 @@
 #define KEY_TREND_VALUE 11
 #define KEY_REQUEST_DATA 12
 #define KEY_TIMESTAMP 13
+#define KEY_NOT_MODIFIED 14
+#define KEY_LEDGER_REQUEST 15
+#define KEY_LEDGER_DATA 16
+#define KEY_SETTINGS_HASH 17
+#define KEY_PATIENTS 18
+#define KEY_DISPLAY_AGE 19    // s from the sensor reading to the watch drawing it
+#define KEY_DISPLAY_DELAY 20  // ms from receiving a reading to drawing it
+#define KEY_PATIENT_TIMESTAMPS 21  // int32 per patient held, little endian
+#define KEY_REQUEST_INTERVAL 22    // minutes between regular requests; the phone pushes no more often
+
+// Accounts that follow several patients get all their latest readings in one
+// KEY_PATIENTS byte array, little endian:
+// [count, { int16 value, int8 trend, int32 timestamp, char initials[2] }...]
+// Patient 0 is the one also sent through KEY_GLUCOSE_VALUE and friends.
+// Requests report the reading held of each patient in the same order
+// (KEY_PATIENT_TIMESTAMPS); with one patient, KEY_TIMESTAMP alone.
+#define MAX_PATIENTS 4
+#define PATIENT_RECORD_SIZE 9
 
 // Trend direction values (matching Dexcom conventions)
 // 1 => ⬇️, 2 => ↘️, 3 => ➡️, 4 => ↗️, 5 => ⬆️
@@ -20,6 +38,30 @@ typedef enum {
   TREND_UNKNOWN = -1        // Unknown/no data
 } GlucoseTrend;
 
+// Glucose value projected to the current time from the last reading
+typedef struct {
+  int value;        // mg/dL, 0 if there is no usable data
+  int error_bound;  // +/- mg/dL of the projection, 0 for a measured value
+  bool estimated;   // value is a projection, not the reading itself
+} GlucoseEstimate;
+
+// Latest reading of one followed patient
+typedef struct {
+  int value;          // mg/dL, 0 once the reading is stale
+  int trend;          // GlucoseTrend
+  time_t timestamp;
+  char initials[3];
+} PatientReading;
+
+// How old the readings were when they were drawn, since launch
+typedef struct {
+  int32_t current_s;  // age of the reading held now, -1 without one
+  uint16_t count;
+  int32_t last_s;
+  int32_t max_s;
+  int32_t total_s;
+} DataAgeStats;
+
 // Callback type for receiving glucose data
 typedef void (*GlucoseDataCallback)(int glucose_value, int trend_value);
 
@@ -27,9 +69,14 @@ typedef void (*GlucoseDataCallback)(int glucose_value, int trend_value);
 // This allows the main app to handle settings without AppSync conflicts
 typedef void (*SettingsCallback)(uint32_t key, int value);
 
-// Initialize message communication
+// Callback type for phone connection changes; the messenger owns the
+// connection service subscription and forwards every event here
+typedef void (*ConnectionCallback)(bool connected);
+
+// Initialize message communication and restore the last persisted reading
 // Note: Call this BEFORE app_message_open() and AppSync init
-void pebble_messenger_init(GlucoseDataCallback glucose_callback, SettingsCallback settings_callback);
+void pebble_messenger_init(GlucoseDataCallback glucose_callback, SettingsCallback settings_callback,
+                           ConnectionCallback connection_callback);
 
 // Allow re-registering handlers after AppSync sets its callbacks
 void pebble_messenger_register_handlers(void);
@@ -44,8 +91,49 @@ void pebble_messenger_get_glucose(int *glucose_value, int *trend_value);
 // Check if glucose data has been received
 bool pebble_messenger_has_glucose_data(void);
 
+// Number of patients in the last KEY_PATIENTS message; 0 when the phone
+// follows a single patient
+int pebble_messenger_patient_count(void);
+
+// Reading of patient index (0 .. pebble_messenger_patient_count() - 1)
+void pebble_messenger_get_patient(int index, PatientReading *patient);
+
+// Enable projecting the last reading along its trend between readings
+void pebble_messenger_set_estimation_enabled(bool enabled);
+
+// Get the value to display now: the last reading, or its projection when
+// estimation is enabled and the reading is old enough to have drifted
+void pebble_messenger_get_estimate(GlucoseEstimate *estimate);
+
+// Hash of the settings the watch has stored (see settings_hash in TextWatch.c);
+// every request reports it so the phone only sends settings that differ
+void pebble_messenger_set_settings_hash(uint32_t hash);
+
+// Call once a received reading is on screen: records how old it was there.
+// The next request reports it so the phone can keep per-stage histograms
+void pebble_messenger_reading_displayed(void);
+
+// Age of the readings drawn since launch
+void pebble_messenger_get_data_age(DataAgeStats *stats);
+
+// Whether the phone app is connected; requests are suspended while it is not
+bool pebble_messenger_is_connected(void);
+
+// Stretch the regular request interval by this factor (power profiles)
+void pebble_messenger_set_request_scale(int scale);
+
+// Minutes between regular glucose requests; longer while estimating and
+// stretched by the request scale
+int pebble_messenger_request_interval_minutes(void);
+
 // Request glucose data from phone
 void pebble_messenger_request_glucose(void);
 
+#if DEBUG
+// Soak mode: behave as if the phone sent this reading now, without
+// persisting it (soak runs must not wear the flash)
+void pebble_messenger_inject_glucose(int glucose_value, int trend_value);
+#endif
+
 // Cleanup function
 void pebble_messenger_deinit(void);
\ No newline at end of file
@@ -0,0 +1,47 @@
+#pragma once
+
+// Include <pebble.h> (app) or <pebble_worker.h> (worker) before this header.
+// Protocol between the watchface and its background worker (worker_src/).
+// While it runs, the worker owns the persisted readings: the face forwards
+// each new one through AppWorkerMessage, the worker appends it to a short
+// history in the persistent storage both share, and the face reads that
+// history once at launch.
+
+// Messages exchanged through app_worker_send_message
+#define WORKER_MSG_READING 2  // app -> worker: one glucose reading
+
+// Persistent storage key of the worker's reading history (shared with the app)
+#define PERSIST_KEY_WORKER_HISTORY 101
+
+// Number of readings the worker keeps (one hour at 5 minute intervals)
+#define WORKER_HISTORY_SIZE 12
+
+// Consider data stale after 15 minutes
+#define GLUCOSE_STALE_SECONDS (15 * 60)
+
+// One reading as kept in persistent storage
+typedef struct __attribute__((__packed__)) {
+  int32_t timestamp;
+  int16_t value;
+  int8_t trend;
+} StoredReading;
+
+// Reading history kept in shared persistent storage, oldest first
+typedef struct __attribute__((__packed__)) {
+  uint8_t count;
+  StoredReading readings[WORKER_HISTORY_SIZE];
+} ReadingHistory;
+
+// A reading fits into one message: value in the low 12 bits of data0, trend
+// (offset by one so unknown is 0) in the high 4 bits, timestamp in data1/data2
+static inline void worker_message_pack(AppWorkerMessage *message, const StoredReading *reading) {
+  message->data0 = (uint16_t)((reading->value & 0x0FFF) | (((reading->trend + 1) & 0xF) << 12));
+  message->data1 = (uint16_t)((uint32_t)reading->timestamp & 0xFFFF);
+  message->data2 = (uint16_t)((uint32_t)reading->timestamp >> 16);
+}
+
+static inline void worker_message_unpack(const AppWorkerMessage *message, StoredReading *reading) {
+  reading->value = (int16_t)(message->data0 & 0x0FFF);
+  reading->trend = (int8_t)((message->data0 >> 12) - 1);
+  reading->timestamp = (int32_t)(((uint32_t)message->data2 << 16) | message->data1);
+}
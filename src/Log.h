@@ -0,0 +1,48 @@
+#pragma once
+
+// Leveled logging that compiles away below LOG_LEVEL, format strings
+// included. Set the level with LOG_LEVEL=<none|error|warning|info|debug>
+// when building (see wscript); debug builds default to debug, release
+// builds to warning.
+// Include pebble.h (or pebble_worker.h) before this header.
+
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARNING 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+
+#ifndef LOG_LEVEL
+#if DEBUG
+#define LOG_LEVEL LOG_LEVEL_DEBUG
+#else
+#define LOG_LEVEL LOG_LEVEL_WARNING
+#endif
+#endif
+
+// Dead code: arguments stay type-checked but no call or string is emitted
+#define LOG_DISCARD(level, ...) do { if (0) APP_LOG(level, __VA_ARGS__); } while (0)
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) APP_LOG(APP_LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) LOG_DISCARD(APP_LOG_LEVEL_ERROR, __VA_ARGS__)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARNING
+#define LOG_WARNING(...) APP_LOG(APP_LOG_LEVEL_WARNING, __VA_ARGS__)
+#else
+#define LOG_WARNING(...) LOG_DISCARD(APP_LOG_LEVEL_WARNING, __VA_ARGS__)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(...) APP_LOG(APP_LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...) LOG_DISCARD(APP_LOG_LEVEL_INFO, __VA_ARGS__)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) APP_LOG(APP_LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) LOG_DISCARD(APP_LOG_LEVEL_DEBUG, __VA_ARGS__)
+#endif
@@ -0,0 +1,97 @@
+#include "PowerLedger.h"
+#include "WorkQueue.h"
+#include <time.h>
+
+// Persistent storage key for the ledger (after the reading and worker history)
+#define PERSIST_KEY_LEDGER 102
+
+#define SECONDS_PER_HOUR (60 * 60)
+
+typedef struct __attribute__((__packed__)) {
+  int32_t hour;                       // Unix time / SECONDS_PER_HOUR
+  uint16_t counts[LEDGER_COUNTERS];
+} LedgerBucket;
+
+// Fits a single persist key (256 bytes)
+typedef struct __attribute__((__packed__)) {
+  uint8_t head;                       // Index of the current hour
+  uint8_t count;                      // Hours in use
+  LedgerBucket buckets[LEDGER_HOURS];
+} LedgerRing;
+
+static LedgerRing s_ring;
+
+static void save_ledger(void) {
+  s_ring.buckets[s_ring.head].counts[LEDGER_PERSIST_WRITES]++;
+  persist_write_data(PERSIST_KEY_LEDGER, &s_ring, sizeof(s_ring));
+}
+
+// Deferred: counting happens inside draw and input handlers
+static void save_ledger_job(void *context) {
+  save_ledger();
+}
+
+// The bucket for this hour; moving to a new hour queues a save of the finished one
+static LedgerBucket *current_bucket(void) {
+  time_t now = time(NULL);
+  const int32_t hour = (now == (time_t)-1) ? 0 : (int32_t)(now / SECONDS_PER_HOUR);
+
+  if (s_ring.count > 0 && s_ring.buckets[s_ring.head].hour == hour) {
+    return &s_ring.buckets[s_ring.head];
+  }
+
+  const bool finished_hour = s_ring.count > 0;
+  if (finished_hour) {
+    s_ring.head = (s_ring.head + 1) % LEDGER_HOURS;
+  }
+  if (s_ring.count < LEDGER_HOURS) {
+    s_ring.count++;
+  }
+  memset(&s_ring.buckets[s_ring.head], 0, sizeof(LedgerBucket));
+  s_ring.buckets[s_ring.head].hour = hour;
+
+  if (finished_hour) {
+    work_queue_defer(save_ledger_job, NULL);
+  }
+  return &s_ring.buckets[s_ring.head];
+}
+
+void power_ledger_init(void) {
+  memset(&s_ring, 0, sizeof(s_ring));
+  if (persist_read_data(PERSIST_KEY_LEDGER, &s_ring, sizeof(s_ring)) != (int)sizeof(s_ring)
+      || s_ring.head >= LEDGER_HOURS || s_ring.count > LEDGER_HOURS) {
+    // Missing, or written by a build with other counters
+    memset(&s_ring, 0, sizeof(s_ring));
+  }
+}
+
+void power_ledger_count(LedgerCounter counter, uint32_t amount) {
+  if (counter >= LEDGER_COUNTERS) return;
+
+  LedgerBucket *bucket = current_bucket();
+  const uint32_t value = bucket->counts[counter] + amount;
+  bucket->counts[counter] = (value > UINT16_MAX || value < amount) ? UINT16_MAX : (uint16_t)value;
+}
+
+size_t power_ledger_serialize(uint8_t *buffer, size_t size) {
+  const size_t length = 2 + s_ring.count * sizeof(LedgerBucket);
+  if (!buffer || size < length) {
+    return 0;
+  }
+
+  buffer[0] = LEDGER_COUNTERS;
+  buffer[1] = s_ring.count;
+  uint8_t *cursor = buffer + 2;
+  for (uint8_t i = 0; i < s_ring.count; i++) {
+    const int index = (s_ring.head + LEDGER_HOURS - s_ring.count + 1 + i) % LEDGER_HOURS;
+    memcpy(cursor, &s_ring.buckets[index], sizeof(LedgerBucket));
+    cursor += sizeof(LedgerBucket);
+  }
+  return length;
+}
+
+void power_ledger_deinit(void) {
+  if (s_ring.count > 0) {
+    save_ledger();
+  }
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <pebble.h>
+
+// Activity counters kept per hour, to compare what builds and settings cost.
+// The last LEDGER_HOURS hours are persisted and can be sent to the phone.
+
+typedef enum {
+  LEDGER_REQUESTS = 0,     // Glucose requests sent
+  LEDGER_INBOUND,          // Messages received from the phone
+  LEDGER_INBOUND_BYTES,    // Their dictionary size in bytes
+  LEDGER_ANIMATIONS,       // Property animations scheduled
+  LEDGER_REDRAW_TOP,       // top_info_update_proc runs
+  LEDGER_REDRAW_BOTTOM,    // bottom_info_background_update_proc runs
+  LEDGER_REDRAW_ARROW,     // bottom_arrow_update_proc runs
+  LEDGER_TAPS,             // Taps handled (after coalescing)
+  LEDGER_PERSIST_WRITES,   // persist_write_* calls
+  LEDGER_COUNTERS
+} LedgerCounter;
+
+#define LEDGER_HOURS 10
+
+// Restore the persisted ring (call once at startup)
+void power_ledger_init(void);
+
+// Add to a counter of the current hour; counters saturate
+void power_ledger_count(LedgerCounter counter, uint32_t amount);
+
+// Write the ring, oldest hour first, as
+// [LEDGER_COUNTERS, hours, { int32 hour since epoch, uint16 counts[] }...]
+// Returns the bytes written, 0 if the buffer is too small
+size_t power_ledger_serialize(uint8_t *buffer, size_t size);
+
+// Save the current hour before exiting
+void power_ledger_deinit(void);
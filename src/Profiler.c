@@ -0,0 +1,84 @@
+#include "Profiler.h"
+#include "Log.h"
+
+#if DEBUG
+
+typedef struct {
+  uint16_t count;
+  uint16_t min_ms;
+  uint16_t max_ms;
+  uint32_t total_ms;
+} SiteStats;
+
+static const char *const SITE_NAMES[PROFILE_SITES] = {
+  "tick", "display", "tap", "inbox", "settings", "top", "bottom", "arrow", "invert"
+};
+static const char *const HEAP_POINT_NAMES[HEAP_POINTS] = { "load", "trans", "msg" };
+
+static SiteStats s_sites[PROFILE_SITES];
+static size_t s_heap_used[HEAP_POINTS];
+static size_t s_heap_free[HEAP_POINTS];
+static size_t s_heap_used_max = 0;   // High-water mark over all samples
+static HeapPoint s_heap_last = HEAP_WINDOW_LOAD;
+
+uint32_t profiler_now_ms(void) {
+  time_t seconds;
+  uint16_t ms;
+  time_ms(&seconds, &ms);
+  // Wraps, but differences stay right
+  return (uint32_t)seconds * 1000 + ms;
+}
+
+void profiler_scope_end(ProfileScope *scope) {
+  SiteStats *stats = &s_sites[scope->site];
+  if (stats->count == UINT16_MAX) return;
+
+  const uint32_t elapsed = profiler_now_ms() - scope->start_ms;
+  const uint16_t ms = elapsed > UINT16_MAX ? UINT16_MAX : (uint16_t)elapsed;
+  if (stats->count == 0 || ms < stats->min_ms) stats->min_ms = ms;
+  if (ms > stats->max_ms) stats->max_ms = ms;
+  stats->total_ms += ms;
+  stats->count++;
+}
+
+void profiler_sample_heap(HeapPoint point) {
+  const size_t used = heap_bytes_used();
+  s_heap_used[point] = used;
+  s_heap_free[point] = heap_bytes_free();
+  s_heap_last = point;
+  if (used > s_heap_used_max) {
+    s_heap_used_max = used;
+  }
+}
+
+// One line per site that ran: name count min/avg/max (ms)
+void profiler_format(char *buffer, size_t size) {
+  size_t length = 0;
+  buffer[0] = '\0';
+  for (int i = 0; i < PROFILE_SITES && length < size; i++) {
+    const SiteStats *stats = &s_sites[i];
+    if (stats->count == 0) continue;
+    length += snprintf(buffer + length, size - length, "%s %u %u/%lu/%u\n", SITE_NAMES[i],
+                       stats->count, stats->min_ms, (unsigned long)(stats->total_ms / stats->count), stats->max_ms);
+  }
+  if (length < size) {
+    snprintf(buffer + length, size - length, "heap %u+%u hw %u",
+             (unsigned)s_heap_used[s_heap_last], (unsigned)s_heap_free[s_heap_last], (unsigned)s_heap_used_max);
+  }
+}
+
+void profiler_dump(void) {
+  for (int i = 0; i < PROFILE_SITES; i++) {
+    const SiteStats *stats = &s_sites[i];
+    if (stats->count == 0) continue;
+    LOG_INFO("Profile %s: n=%u min=%u avg=%lu max=%u ms", SITE_NAMES[i],
+            stats->count, stats->min_ms, (unsigned long)(stats->total_ms / stats->count), stats->max_ms);
+  }
+  for (int i = 0; i < HEAP_POINTS; i++) {
+    LOG_INFO("Heap after %s: used=%u free=%u", HEAP_POINT_NAMES[i],
+            (unsigned)s_heap_used[i], (unsigned)s_heap_free[i]);
+  }
+  LOG_INFO("Heap high-water mark: %u bytes used", (unsigned)s_heap_used_max);
+}
+
+#endif
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <pebble.h>
+
+// Debug builds only (DEBUG=1): time spent per event handler and update proc,
+// and heap usage at a few points. Release builds compile the macros away.
+
+typedef enum {
+  PROFILE_MINUTE_TICK = 0,
+  PROFILE_DISPLAY_TIME,
+  PROFILE_TAP,
+  PROFILE_INBOX,
+  PROFILE_SETTINGS,
+  PROFILE_DRAW_TOP,
+  PROFILE_DRAW_BOTTOM,
+  PROFILE_DRAW_ARROW,
+  PROFILE_DRAW_INVERTER,
+  PROFILE_SITES
+} ProfileSite;
+
+typedef enum {
+  HEAP_WINDOW_LOAD = 0,   // After the first frame is built
+  HEAP_TRANSITION,        // After the lines settled
+  HEAP_MESSAGE,           // After a message from the phone was handled
+  HEAP_POINTS
+} HeapPoint;
+
+#if DEBUG
+
+typedef struct {
+  uint8_t site;
+  uint32_t start_ms;
+} ProfileScope;
+
+uint32_t profiler_now_ms(void);
+void profiler_scope_end(ProfileScope *scope);
+void profiler_sample_heap(HeapPoint point);
+
+// Short summary for the on-screen overlay
+void profiler_format(char *buffer, size_t size);
+
+// Log every site and heap sample
+void profiler_dump(void);
+
+// Times the rest of the enclosing block, early returns included
+#define PROFILE_SCOPE(site) \
+  ProfileScope profile_scope __attribute__((cleanup(profiler_scope_end))) = { (site), profiler_now_ms() }
+#define PROFILE_HEAP(point) profiler_sample_heap(point)
+
+#else
+
+#define PROFILE_SCOPE(site)
+#define PROFILE_HEAP(point)
+
+#endif
@@ -3,16 +3,24 @@
 
 #include "num2words.h"
 #include "AppRequests.h"
+#include "WorkQueue.h"
+#include "PowerLedger.h"
+#include "Profiler.h"
+#include "Log.h"
 
 #define NUM_LINES 4
-#define LINE_LENGTH 7
+// Bytes of text a line can hold; words are multibyte UTF-8
+#define LINE_LENGTH 14
 #define BUFFER_SIZE (LINE_LENGTH + 2)
+// Width of a line of text in pixels
+#define LINE_WIDTH 144
 #define ROW_HEIGHT 37
 #define TEXT_LAYER_HEIGHT 50
 #define SCREEN_HEIGHT 168
 #define TOP_TEXT_RESERVE 21
 #define BOTTOM_TEXT_RESERVE 21
 #define BOTTOM_ARROW_WIDTH 18
+#define BOTTOM_DATE_WIDTH 64   // "dd.mm.yyyy" in GOTHIC_18
 #define DATE_BUFFER_SIZE 16
 #define INFO_BUFFER_SIZE 24
 
@@ -20,6 +28,8 @@
 #define INVERT_KEY 0
 #define TEXT_ALIGN_KEY 1
 #define LANGUAGE_KEY 2
+#define ESTIMATE_KEY 3
+#define POWER_KEY 4
 
 #define TEXT_ALIGN_CENTER 0
 #define TEXT_ALIGN_LEFT 1
@@ -32,9 +42,39 @@
 // Delay from the start of the current layer going out until the next layer slides in
 #define ANIMATION_OUT_IN_DELAY 100
 
-#define LINE_APPEND_MARGIN 0
-// We can add a new word to a line if there are at least this many characters free after
-#define LINE_APPEND_LIMIT (LINE_LENGTH - LINE_APPEND_MARGIN)
+// Taps arriving within this window after a handled tap are ignored
+#define TAP_COALESCE_MS 500
+// How long the date stays on screen after a tap before the time returns
+#define DATE_DISPLAY_TIMEOUT_MS (60 * 1000)
+
+// The fuzzy time changes every five minutes, 288 times a day
+#define PHRASE_BUCKET_SECONDS (5 * 60)
+#define PHRASE_BUCKETS (24 * 60 * 60 / PHRASE_BUCKET_SECONDS)
+// Wait for the transition to settle before preparing the next phrase
+#define PHRASE_PRECOMPUTE_DELAY_MS 1500
+// Fire the flip timer just after a bucket starts, never before it
+#define PHRASE_FLIP_MARGIN_MS 20
+
+#define LINE_APPEND_MARGIN 4
+// We can add a new word to a line if there are at least this many pixels free after
+#define LINE_APPEND_LIMIT (LINE_WIDTH - LINE_APPEND_MARGIN)
+
+// Power profiles; automatic picks night during quiet hours and saver on low battery.
+// Only the profile choice (POWER_KEY) is a setting: the thresholds, quiet hours
+// and the POWER_PROFILES table below are fixed at build time.
+#define POWER_AUTO 0
+#define POWER_FULL 1
+#define POWER_SAVER 2
+#define POWER_NIGHT 3
+#define SAVER_BATTERY_PERCENT 20
+// Leave saver only once the battery is clearly above the threshold again
+#define SAVER_EXIT_BATTERY_PERCENT 30
+#define QUIET_START_HOUR 23
+#define QUIET_END_HOUR 7
+
+// Index into the per-font word widths
+#define FONT_LIGHT 0
+#define FONT_BOLD 1
 
 static AppSync sync;
 static uint8_t sync_buffer[64];
@@ -42,6 +82,58 @@ static uint8_t sync_buffer[64];
 static int text_align = TEXT_ALIGN_CENTER;
 static bool invert = false;
 static Language lang = EN_US;
+static bool estimate_glucose = false;
+static int power_setting = POWER_AUTO;
+
+typedef struct {
+	bool animate;                 // Slide lines in, or swap them in place
+	bool taps;                    // Tapping shows the date
+	uint8_t request_scale;        // Multiplies the glucose request interval
+	uint8_t top_refresh_minutes;  // Minutes between updates of the top bar time
+} PowerProfile;
+
+static const PowerProfile POWER_PROFILES[] = {
+	[POWER_FULL]  = { .animate = true,  .taps = true,  .request_scale = 1, .top_refresh_minutes = 1 },
+	[POWER_SAVER] = { .animate = false, .taps = false, .request_scale = 2, .top_refresh_minutes = 1 },
+	[POWER_NIGHT] = { .animate = false, .taps = false, .request_scale = 3, .top_refresh_minutes = 5 },
+};
+
+static int power_mode = POWER_FULL;
+static const PowerProfile *power = &POWER_PROFILES[POWER_FULL];
+
+// Without glucose data the first requests come every request_scale minutes,
+// later ones at the regular interval (the phone app may be gone all night)
+#define NO_DATA_QUICK_RETRIES 5
+static int no_data_requests = 0;
+static bool taps_subscribed = false;
+
+#if DEBUG
+// Soak mode: runs whole days of accelerated time (long press DOWN, in the
+// DEBUG=1 watchapp build). Step size, pace and log interval can be
+// overridden with -D
+#ifndef SOAK_STEP_MS
+#define SOAK_STEP_MS 500
+#endif
+#ifndef SOAK_STEP_SECONDS
+#define SOAK_STEP_SECONDS 150
+#endif
+#ifndef SOAK_LOG_EVERY
+#define SOAK_LOG_EVERY 96
+#endif
+
+static AppTimer *soak_timer = NULL;
+static uint32_t soak_iterations = 0;
+static int soak_seconds = 0;
+static uint16_t failed_animations = 0;
+// Time from the start of a transition until its last line settled
+static uint32_t transition_start_ms = 0;
+static uint16_t transition_count = 0;
+static uint32_t transition_total_ms = 0;
+static uint32_t transition_max_ms = 0;
+// Transitions a later one cut short; their time says nothing about the slides
+static uint16_t transition_cancelled = 0;
+static bool transition_cut = false;
+#endif
 
 static Window *window;
 
@@ -54,6 +146,28 @@ typedef struct {
 	PropertyAnimation *animation2;
 } Line;
 
+// Lines, bold flags and layout of one screen of text, ready to be applied
+typedef struct {
+	char text[NUM_LINES][BUFFER_SIZE];
+	char format[NUM_LINES];
+	int numLines;
+	int ypos[NUM_LINES];
+} Phrase;
+
+// Pixel widths of every word the current language can put on screen,
+// measured once per language in the Bitham fonts used for the lines
+typedef struct {
+	uint8_t templates[PHRASE_TEMPLATES][PHRASE_MAX_TOKENS];  // in the font of each word
+	uint8_t hours[24][2];
+	uint8_t days[7];     // bold
+	uint8_t months[12];  // light
+	uint8_t digits[10];  // light
+	uint8_t space[2];
+} WordWidths;
+
+static WordWidths word_widths;
+static int word_widths_lang = -1;
+
 static Line lines[NUM_LINES];
 static Layer *inverter_layer;
 static Layer *top_info_layer;
@@ -67,10 +181,17 @@ static char top_time_buffer[6];
 static char bottom_date_buffer[DATE_BUFFER_SIZE];
 static char bottom_info_buffer[INFO_BUFFER_SIZE];
 static int bottom_trend_direction = TREND_UNKNOWN;
+static int shown_patient = 0;  // Rotates each minute when following several patients
+
+// Launch time, to report how long it takes until the first frame is on screen
+static time_t launch_time_s;
+static uint16_t launch_time_ms;
+static bool first_frame_drawn = false;
 
 static void top_info_update_proc(Layer *layer, GContext *ctx);
 static void battery_state_handler(BatteryChargeState state);
 static void bluetooth_handler(bool connected);
+static void update_power_profile(void);
 static void update_top_time_buffer(struct tm *time);
 static void update_bottom_status(struct tm *time);
 static void apply_bottom_theme(void);
@@ -78,6 +199,7 @@ static void bottom_arrow_update_proc(Layer *layer, GContext *ctx);
 static void bottom_info_background_update_proc(Layer *layer, GContext *ctx);
 
 static void inverter_update_proc(Layer *layer, GContext *ctx) {
+  PROFILE_SCOPE(PROFILE_DRAW_INVERTER);
   GRect bounds = layer_get_bounds(layer);
   // Zeichnet ein einfaches Highlight. Passe GColor an dein Design an:
   // z.B. GColorWhite für heller Hintergrund, GColorBlack für dunkles Design.
@@ -171,7 +293,21 @@ static void draw_battery_icon(GContext *ctx, GColor color, GRect bounds, int cen
 	graphics_context_set_stroke_color(ctx, color);
 }
 
+static uint32_t ms_since_launch(void) {
+	time_t now_s;
+	uint16_t now_ms;
+	time_ms(&now_s, &now_ms);
+	return (uint32_t)(now_s - launch_time_s) * 1000 + now_ms - launch_time_ms;
+}
+
 static void top_info_update_proc(Layer *layer, GContext *ctx) {
+	PROFILE_SCOPE(PROFILE_DRAW_TOP);
+	power_ledger_count(LEDGER_REDRAW_TOP, 1);
+	if (!first_frame_drawn) {
+		first_frame_drawn = true;
+		LOG_DEBUG("First frame drawn %lu ms after launch", (unsigned long)ms_since_launch());
+	}
+
 	GRect bounds = layer_get_bounds(layer);
 	GColor fg = invert ? GColorBlack : GColorWhite;
 	GColor bg = invert ? GColorWhite : GColorBlack;
@@ -205,18 +341,22 @@ static void top_info_update_proc(Layer *layer, GContext *ctx) {
 	draw_battery_icon(ctx, fg, bounds, center_y);
 }
 
-static void battery_state_handler(BatteryChargeState state) {
-	current_battery_state = state;
+// Deferred: battery and BT icons, redrawn once after a transition
+static void redraw_top_info_job(void *context) {
 	if (top_info_layer) {
 		layer_mark_dirty(top_info_layer);
 	}
 }
 
+static void battery_state_handler(BatteryChargeState state) {
+	current_battery_state = state;
+	update_power_profile();
+	work_queue_defer(redraw_top_info_job, NULL);
+}
+
 static void bluetooth_handler(bool connected) {
 	bluetooth_connected = connected;
-	if (top_info_layer) {
-		layer_mark_dirty(top_info_layer);
-	}
+	work_queue_defer(redraw_top_info_job, NULL);
 }
 
 static void apply_bottom_theme(void) {
@@ -236,6 +376,8 @@ static void apply_bottom_theme(void) {
 }
 
 static void bottom_info_background_update_proc(Layer *layer, GContext *ctx) {
+	PROFILE_SCOPE(PROFILE_DRAW_BOTTOM);
+	power_ledger_count(LEDGER_REDRAW_BOTTOM, 1);
 	GRect bounds = layer_get_bounds(layer);
 	GColor bg = invert ? GColorWhite : GColorBlack;
 	GColor fg = invert ? GColorBlack : GColorWhite;
@@ -246,25 +388,43 @@ static void bottom_info_background_update_proc(Layer *layer, GContext *ctx) {
 	graphics_draw_line(ctx, GPoint(bounds.origin.x, center_y - 10), GPoint(bounds.origin.x + bounds.size.w, center_y - 10));
 }
 
-static void get_glucose_data(int *glucose_value, int *trend_value) {
-	// Get the last received values from the messenger
-	pebble_messenger_get_glucose(glucose_value, trend_value);
-}
+// Format the glucose value and trend arrow from the messenger's current data
+static void update_glucose_display(void) {
+	GlucoseEstimate estimate;
+	int trend_value = TREND_UNKNOWN;
+	pebble_messenger_get_estimate(&estimate);
+	pebble_messenger_get_glucose(NULL, &trend_value);
+
+	// Several patients: prefix their initials; the primary one keeps the projection
+	const char *initials = "";
+	PatientReading patient;
+	if (shown_patient >= pebble_messenger_patient_count()) {
+		shown_patient = 0;
+	}
+	if (pebble_messenger_patient_count() > 1) {
+		pebble_messenger_get_patient(shown_patient, &patient);
+		initials = patient.initials;
+		if (shown_patient > 0) {
+			estimate = (GlucoseEstimate) { .value = patient.value };
+			trend_value = patient.trend;
+		}
+	}
 
-// Callback when new glucose data is received from phone
-static void glucose_data_received_callback(int glucose_value, int trend_value) {
-	APP_LOG(APP_LOG_LEVEL_INFO, "Glucose data received: %d mg/dL, trend: %d", glucose_value, trend_value);
-	
 	// Update the trend direction for the arrow
 	bottom_trend_direction = trend_value;
-	
-	// Update the glucose display
-	if (glucose_value > 0) {
-		snprintf(bottom_info_buffer, sizeof(bottom_info_buffer), "%d", glucose_value);
+
+	// Show "---" if no data, and mark projected values with a "~"
+	if (estimate.value > 0) {
+		snprintf(bottom_info_buffer, sizeof(bottom_info_buffer), "%s%s%s%d",
+			initials, initials[0] ? " " : "", estimate.estimated ? "~" : "", estimate.value);
 	} else {
-		snprintf(bottom_info_buffer, sizeof(bottom_info_buffer), "---");
+		snprintf(bottom_info_buffer, sizeof(bottom_info_buffer), "%s%s---",
+			initials, initials[0] ? " " : "");
 	}
-	
+	if (estimate.estimated) {
+		LOG_DEBUG("Glucose estimate: %d +/- %d mg/dL", estimate.value, estimate.error_bound);
+	}
+
 	// Refresh the display layers
 	if (bottom_info_layer) {
 		text_layer_set_text(bottom_info_layer, bottom_info_buffer);
@@ -274,6 +434,18 @@ static void glucose_data_received_callback(int glucose_value, int trend_value) {
 	}
 }
 
+static void glucose_display_job(void *context) {
+	update_glucose_display();
+	pebble_messenger_reading_displayed();
+}
+
+// Callback when new glucose data is received from phone; the bottom bar is
+// updated once the running transition (if any) has finished
+static void glucose_data_received_callback(int glucose_value, int trend_value) {
+	LOG_INFO("Glucose data received: %d mg/dL, trend: %d", glucose_value, trend_value);
+	work_queue_defer(glucose_display_job, NULL);
+}
+
 static void draw_arrow_shape(GContext *ctx, GPoint center, GPoint tip, GColor color) {
 	graphics_context_set_stroke_color(ctx, color);
 	graphics_draw_line(ctx, center, tip);
@@ -315,6 +487,8 @@ static void draw_arrow_shape(GContext *ctx, GPoint center, GPoint tip, GColor co
 }
 
 static void bottom_arrow_update_proc(Layer *layer, GContext *ctx) {
+	PROFILE_SCOPE(PROFILE_DRAW_ARROW);
+	power_ledger_count(LEDGER_REDRAW_ARROW, 1);
 	GRect bounds = layer_get_bounds(layer);
 	GPoint center = GPoint(bounds.size.w / 2, bounds.size.h / 2);
 	const int length = (bounds.size.w < bounds.size.h ? bounds.size.w : bounds.size.h) / 2 - 2;
@@ -358,31 +532,14 @@ static void update_bottom_status(struct tm *time) {
 		bottom_date_buffer[sizeof(bottom_date_buffer) - 1] = '\0';
 	}
 	
-	// Get glucose data from messenger (don't request here - requests happen every 5 min in tick handler)
-	int glucose_value = 0;
-	int trend_value = TREND_UNKNOWN;
-	get_glucose_data(&glucose_value, &trend_value);
-	
-	// Update trend direction for arrow display
-	bottom_trend_direction = trend_value;
-	
-	// Format glucose display - show "---" if no data
-	if (glucose_value > 0) {
-		snprintf(bottom_info_buffer, sizeof(bottom_info_buffer), "%d", glucose_value);
-	} else {
-		snprintf(bottom_info_buffer, sizeof(bottom_info_buffer), "---");
-	}
-	
 	// Update display layers
 	if (bottom_date_layer) {
 		text_layer_set_text(bottom_date_layer, bottom_date_buffer);
 	}
-	if (bottom_info_layer) {
-		text_layer_set_text(bottom_info_layer, bottom_info_buffer);
-	}
-	if (bottom_arrow_layer) {
-		layer_mark_dirty(bottom_arrow_layer);
-	}
+
+	// Glucose from the messenger, projected along its trend each minute when
+	// enabled (don't request here - requests happen in the tick handler)
+	update_glucose_display();
 }
 
 static struct tm current_time;  // Store actual time data, not just a pointer
@@ -391,15 +548,99 @@ static struct tm *t = &current_time;  // Keep pointer for compatibility
 static int currentNLines;
 
 static bool showTime = true;
-static int dateTimeout = 0;
+static AppTimer *date_timeout_timer = NULL;
+static AppTimer *tap_coalesce_timer = NULL;
+
+// Time phrase cache, filled ahead of the next bucket boundary between ticks
+static Phrase cached_phrase;
+static int cached_phrase_bucket = -1;
+// Bucket of the time phrase currently on screen, -1 while showing the date
+static int shown_phrase_bucket = -1;
+static AppTimer *phrase_precompute_timer = NULL;
+static AppTimer *phrase_flip_timer = NULL;
+static Phrase date_phrase;
+
+// Move a line layer horizontally, keeping its vertical position
+static void setLayerX(TextLayer *layer, int x)
+{
+	GRect rect = layer_get_frame((Layer *)layer);
+	rect.origin.x = x;
+	layer_set_frame((Layer *)layer, rect);
+}
+
+static bool transitionRunning(void)
+{
+	for (int i = 0; i < NUM_LINES; i++) {
+		if (lines[i].animation1 || lines[i].animation2) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// Animation handlers. Property animations are destroyed by the system once
+// they stop, so the pointers are cleared here to never touch a freed animation.
+static void animationOutStoppedHandler(struct Animation *animation, bool finished, void *context)
+{
+	Line *line = (Line *)context;
+	line->animation1 = NULL;
+}
 
-// Animation handler
 static void animationStoppedHandler(struct Animation *animation, bool finished, void *context)
 {
-	TextLayer *current = (TextLayer *)context;
-	GRect rect = layer_get_frame((Layer *)current);
-	rect.origin.x = 144;
-	layer_set_frame((Layer *)current, rect);
+	Line *line = (Line *)context;
+	line->animation2 = NULL;
+
+	// Park the outgoing layer off screen and make sure the incoming one ends
+	// at its final position, also when the slide was cut short.
+	setLayerX(line->nextLayer, 144);
+	setLayerX(line->currentLayer, 0);
+#if DEBUG
+	if (!finished) {
+		transition_cut = true;
+	}
+#endif
+
+	// Deferred work waits for the last line to settle
+	if (!transitionRunning()) {
+		work_queue_hold(false);
+		PROFILE_HEAP(HEAP_TRANSITION);
+#if DEBUG
+		if (transition_start_ms && transition_cut) {
+			transition_cancelled++;
+		} else if (transition_start_ms) {
+			const uint32_t elapsed = profiler_now_ms() - transition_start_ms;
+			transition_count++;
+			transition_total_ms += elapsed;
+			if (elapsed > transition_max_ms) {
+				transition_max_ms = elapsed;
+			}
+		}
+		transition_start_ms = 0;
+		transition_cut = false;
+#endif
+	}
+}
+
+// Stop any slide still running on this line and snap it to its end state
+static void cancelLineAnimations(Line *line)
+{
+	if (line->animation1) {
+		animation_unschedule(property_animation_get_animation(line->animation1));
+		line->animation1 = NULL;
+	}
+	if (line->animation2) {
+		animation_unschedule(property_animation_get_animation(line->animation2));
+		line->animation2 = NULL;
+	}
+}
+
+// Cut the in-flight transition short so a new one never stacks on top of it
+static void cancelTransition(void)
+{
+	for (int i = 0; i < NUM_LINES; i++) {
+		cancelLineAnimations(&lines[i]);
+	}
 }
 
 // // Animate line
@@ -449,10 +690,8 @@ static void makeAnimationsForLayer(Line *line, int delay) {
     TextLayer *current = line->currentLayer;
     TextLayer *next = line->nextLayer;
 
-    // Clear old animation pointers (animations auto-destroy when finished)
-    // We don't manually destroy them since they may already be destroyed
-    line->animation1 = NULL;
-    line->animation2 = NULL;
+    // A line only ever runs one slide; stop what is left of the previous one
+    cancelLineAnimations(line);
 
     // --- Create first property animation (move current out) ---
     GRect rect_current = layer_get_frame((Layer *)current);
@@ -465,9 +704,20 @@ static void makeAnimationsForLayer(Line *line, int delay) {
             animation_set_duration(anim1, ANIMATION_DURATION);
             animation_set_delay(anim1, delay);
             animation_set_curve(anim1, AnimationCurveEaseIn);
+
+            AnimationHandlers handlers = {
+                .stopped = (AnimationStoppedHandler)animationOutStoppedHandler
+            };
+            animation_set_handlers(anim1, handlers, line);
             animation_schedule(anim1);
+            power_ledger_count(LEDGER_ANIMATIONS, 1);
         }
     }
+#if DEBUG
+    if (!line->animation1) {
+        failed_animations++;
+    }
+#endif
 
     // --- Create second property animation (move next in) ---
     GRect rect_next = layer_get_frame((Layer *)next);
@@ -484,10 +734,24 @@ static void makeAnimationsForLayer(Line *line, int delay) {
             AnimationHandlers handlers = {
                 .stopped = (AnimationStoppedHandler)animationStoppedHandler
             };
-            animation_set_handlers(anim2, handlers, current);
+            animation_set_handlers(anim2, handlers, line);
             animation_schedule(anim2);
+            power_ledger_count(LEDGER_ANIMATIONS, 1);
         }
     }
+
+#if DEBUG
+    if (!line->animation2) {
+        failed_animations++;
+    }
+#endif
+    if (!line->animation2) {
+        // Without an incoming animation nothing would move the layers; jump
+        // straight to the end state instead (layers are swapped by the caller)
+        cancelLineAnimations(line);
+        setLayerX(current, 144);
+        setLayerX(next, 0);
+    }
 }
 
 
@@ -507,10 +771,17 @@ static void updateLayerText(Line *line, TextLayer *layer, const char *text)
 }
 
 // Update line
-static void updateLineTo(Line *line, char *value, int delay)
+static void updateLineTo(Line *line, const char *value, int delay)
 {
 	updateLayerText(line, line->nextLayer, value);
-	makeAnimationsForLayer(line, delay);
+	if (power->animate) {
+		makeAnimationsForLayer(line, delay);
+	} else {
+		// Swap in place, the same end state a finished slide leaves
+		cancelLineAnimations(line);
+		setLayerX(line->currentLayer, 144);
+		setLayerX(line->nextLayer, 0);
+	}
 
 	// Swap current/next layers
 	TextLayer *tmp = line->nextLayer;
@@ -519,7 +790,7 @@ static void updateLineTo(Line *line, char *value, int delay)
 }
 
 // Check to see if the current line needs to be updated
-static bool needToUpdateLine(Line *line, char *nextValue)
+static bool needToUpdateLine(Line *line, const char *nextValue)
 {
 	const char *currentStr = text_layer_get_text(line->currentLayer);
 
@@ -565,30 +836,14 @@ static void configureLightLayer(TextLayer *textlayer)
     text_layer_set_text_alignment(textlayer, lookup_text_alignment(text_align));
 }
 
-// Configure the layers for the given text
-static int configureLayersForText(char text[NUM_LINES][BUFFER_SIZE], char format[])
+// Count the lines of the phrase and calculate where each of them goes
+static void layoutPhrase(Phrase *phrase)
 {
 	int numLines = 0;
-
-	// Set bold layer.
-	int i;
-	for (i = 0; i < NUM_LINES; i++) {
-		if (strlen(text[i]) > 0) {
-			if (format[i] == 'b')
-			{
-				configureBoldLayer(lines[i].nextLayer);
-			}
-			else
-			{
-				configureLightLayer(lines[i].nextLayer);
-			}
-		}
-		else
-		{
-			break;
-		}
+	while (numLines < NUM_LINES && strlen(phrase->text[numLines]) > 0) {
+		numLines++;
 	}
-	numLines = i;
+	phrase->numLines = numLines;
 
 	// Calculate y position of top Line within reserved vertical area
 	int top_reserve = TOP_TEXT_RESERVE - 7;
@@ -615,21 +870,142 @@ static int configureLayersForText(char text[NUM_LINES][BUFFER_SIZE], char format
 		ypos += (available_height - total_height) / 2;
 	}
 
-	// Set y positions for the lines
 	for (int i = 0; i < numLines; i++)
 	{
-		layer_set_frame((Layer *)lines[i].nextLayer, GRect(144, ypos, 144, TEXT_LAYER_HEIGHT));
+		phrase->ypos[i] = ypos;
 		ypos += row_height;
 	}
+}
 
-	return numLines;
+// Configure the next layers for the given phrase
+static void configureLayersForPhrase(const Phrase *phrase)
+{
+	for (int i = 0; i < phrase->numLines; i++) {
+		if (phrase->format[i] == 'b')
+		{
+			configureBoldLayer(lines[i].nextLayer);
+		}
+		else
+		{
+			configureLightLayer(lines[i].nextLayer);
+		}
+		layer_set_frame((Layer *)lines[i].nextLayer, GRect(144, phrase->ypos[i], 144, TEXT_LAYER_HEIGHT));
+	}
+}
+
+static GFont line_font(int font)
+{
+	return fonts_get_system_font(font == FONT_BOLD ? FONT_KEY_BITHAM_42_BOLD : FONT_KEY_BITHAM_42_LIGHT);
+}
+
+// Rendered width of the first length bytes of text
+static uint8_t measure_word(const char *text, size_t length, int font)
+{
+	char word[BUFFER_SIZE] = "";
+	*append_chars(word, word + sizeof(word) - 1, text, length) = '\0';
+
+	GSize size = graphics_text_layout_get_content_size(word, line_font(font),
+		GRect(0, 0, 4 * LINE_WIDTH, TEXT_LAYER_HEIGHT), GTextOverflowModeWordWrap, GTextAlignmentLeft);
+	return size.w > 255 ? 255 : size.w;
+}
+
+// Look up a template word measured earlier so repeated words are measured once
+static bool find_template_width(const PhraseTemplate *templates, int last, const PhraseToken *token, uint8_t *width)
+{
+	const char *text = templates[last].source + token->offset;
+	for (int r = 0; r <= last; r++) {
+		for (int i = 0; i < templates[r].count; i++) {
+			const PhraseToken *other = &templates[r].tokens[i];
+			if (other == token) {
+				return false;
+			}
+			if (other->type == TOKEN_WORD && other->length == token->length
+				&& other->flags == token->flags
+				&& memcmp(templates[r].source + other->offset, text, token->length) == 0) {
+				*width = word_widths.templates[r][i];
+				return true;
+			}
+		}
+	}
+	return false;
 }
 
+// Measure the words of the language; cheap after the first call for a language
+static void load_word_widths(void)
+{
+	if (word_widths_lang == (int) lang) {
+		return;
+	}
+
+	const PhraseTemplate *templates = phrase_templates(lang);
+	for (int r = 0; r < PHRASE_TEMPLATES; r++) {
+		for (int i = 0; i < templates[r].count; i++) {
+			const PhraseToken *token = &templates[r].tokens[i];
+			if (token->type != TOKEN_WORD) {
+				continue;
+			}
+			if (!find_template_width(templates, r, token, &word_widths.templates[r][i])) {
+				word_widths.templates[r][i] = measure_word(templates[r].source + token->offset, token->length,
+					(token->flags & PHRASE_TOKEN_BOLD) ? FONT_BOLD : FONT_LIGHT);
+			}
+		}
+	}
+
+	for (int font = FONT_LIGHT; font <= FONT_BOLD; font++) {
+		for (int h = 0; h < 24; h++) {
+			const char *hour = get_hour(lang, h);
+			// The afternoon repeats the morning hours
+			if (h >= 12 && strcmp(hour, get_hour(lang, h - 12)) == 0) {
+				word_widths.hours[h][font] = word_widths.hours[h - 12][font];
+			} else {
+				word_widths.hours[h][font] = measure_word(hour, strlen(hour), font);
+			}
+		}
+		// A space is the difference between two letters with and without it
+		const int spaced = measure_word("n n", 3, font);
+		const int joined = measure_word("nn", 2, font);
+		word_widths.space[font] = spaced > joined ? spaced - joined : 0;
+	}
+
+	for (int d = 0; d < 7; d++) {
+		const char *day = get_day(lang, d);
+		word_widths.days[d] = measure_word(day, strlen(day), FONT_BOLD);
+	}
+	for (int m = 0; m < 12; m++) {
+		const char *month = get_month(lang, m);
+		word_widths.months[m] = measure_word(month, strlen(month), FONT_LIGHT);
+	}
+	for (int n = 0; n < 10; n++) {
+		const char digit = '0' + n;
+		word_widths.digits[n] = measure_word(&digit, 1, FONT_LIGHT);
+	}
+
+	word_widths_lang = lang;
+}
+
+// Cached pixel width of a token of the given template
+static int token_width(int rel_index, int token_index, const PhraseToken *token, int hour_index)
+{
+	const int font = (token->flags & PHRASE_TOKEN_BOLD) ? FONT_BOLD : FONT_LIGHT;
+	switch (token->type) {
+		case TOKEN_HOUR:
+			return word_widths.hours[hour_index][font];
+		case TOKEN_NEXT_HOUR:
+			return word_widths.hours[(hour_index + 1) % 24][font];
+		default:
+			return word_widths.templates[rel_index][token_index];
+	}
+}
+
+// Pack the words of the compiled phrase template into lines. Words are
+// written straight into the line buffers, no intermediate string is built.
 static void time_to_lines(int hours, int minutes, int seconds, char lines[NUM_LINES][BUFFER_SIZE], char format[])
 {
-	int length = NUM_LINES * BUFFER_SIZE + 1;
-	char timeStr[length];
-	time_to_words(lang, hours, minutes, seconds, timeStr, length);
+	int hour_index;
+	const PhraseTemplate *phrase = time_to_template(lang, hours, minutes, seconds, &hour_index);
+	const int rel_index = phrase - phrase_templates(lang);
+
+	load_word_widths();
 	
 	// Empty all lines
 	for (int i = 0; i < NUM_LINES; i++)
@@ -637,128 +1013,317 @@ static void time_to_lines(int hours, int minutes, int seconds, char lines[NUM_LI
 		lines[i][0] = '\0';
 	}
 
-	char *start = timeStr;
-	char *end = strstr(start, " ");
 	int l = 0;
-	while (end != NULL && l < NUM_LINES) {
-		// Check word for bold prefix
-		if (*start == '*' && end - start > 1)
+	for (int i = 0; i < phrase->count && l < NUM_LINES; i++) {
+		const PhraseToken *token = &phrase->tokens[i];
+		char *cursor = lines[l];
+		const char *end = lines[l] + BUFFER_SIZE - 1;
+		size_t length;
+		const char *word = phrase_token_text(lang, phrase, token, hour_index, &length);
+
+		format[l] = (token->flags & PHRASE_TOKEN_BOLD) ? 'b' : ' ';
+		cursor = append_chars(cursor, end, word, length);
+
+		// Can we add another word to the line? Only if both words are
+		// formatted normal and the pair fits the line in pixels and bytes.
+		if (token->flags & PHRASE_TOKEN_GLUE)
 		{
-			// Mark line bold and move start to the first character of the word
-			format[l] = 'b';
-			start++;
-		}
-		else
-		{
-			// Mark line normal
-			format[l] = ' ';
-		}
-
-		// Can we add another word to the line?
-		if (format[l] == ' ' && *(end + 1) != '*'    // are both lines formatted normal?
-			&& end - start < LINE_APPEND_LIMIT - 1)  // is the first word is short enough?
-		{
-			// See if next word fits
-			char *try = strstr(end + 1, " ");
-			if (try != NULL && try - start <= LINE_APPEND_LIMIT)
+			size_t next_length;
+			const char *next_word = phrase_token_text(lang, phrase, &phrase->tokens[i + 1], hour_index, &next_length);
+			const int width = token_width(rel_index, i, token, hour_index)
+				+ word_widths.space[FONT_LIGHT]
+				+ token_width(rel_index, i + 1, &phrase->tokens[i + 1], hour_index);
+			if (width <= LINE_APPEND_LIMIT && length + 1 + next_length <= LINE_LENGTH)
 			{
-				end = try;
+				cursor = append_chars(cursor, end, " ", 1);
+				cursor = append_chars(cursor, end, next_word, next_length);
+				i++;
 			}
 		}
 
-		// copy to line
-		*end = '\0';
-		strcpy(lines[l++], start);
-
-		// Look for next word
-		start = end + 1;
-		end = strstr(start, " ");
+		*cursor = '\0';
+		l++;
 	}
-	
 }
 
-// Make a date string
+// Make a date string: the weekday in bold, then month and day of month,
+// sharing a line when they fit
 static void date_to_lines(int day, int date, int month, char lines[NUM_LINES][BUFFER_SIZE], char format[]) {
-  int length = NUM_LINES * BUFFER_SIZE + 1;
-  char dateStr[length];
-  
-  // Empty all lines
+	char number[4];
+	itoa10(date, number);
+	const char *weekday = get_day(lang, day);
+	const char *month_name = get_month(lang, month);
+
+	load_word_widths();
+
+	// Empty all lines
 	for (int i = 0; i < NUM_LINES; i++)
 	{
 		lines[i][0] = '\0';
-    format[i] = ' ';
+		format[i] = ' ';
 	}
-  format[0] = 'b';
-  
-  date_to_words(lang, day, date, month, dateStr, length);
-  
-  char *start = dateStr;
-	char *end = strstr(start, " ");
-	int l = 0;
-	while (end != NULL && l < NUM_LINES) {
-    // See if next word fits
-    char *try = strstr(end + 1, " ");
-    if (try != NULL && try - start <= LINE_APPEND_LIMIT)
-    {
-      end = try;
-    }
+	format[0] = 'b';
 
-		// copy to line
-		*end = '\0';
-		strcpy(lines[l++], start);
+	*append_chars(lines[0], lines[0] + BUFFER_SIZE - 1, weekday, strlen(weekday)) = '\0';
+
+	int number_width = 0;
+	for (const char *digit = number; *digit; digit++) {
+		number_width += word_widths.digits[*digit - '0'];
+	}
+	const int width = word_widths.months[month] + word_widths.space[FONT_LIGHT] + number_width;
 
-		// Look for next word
-		start = end + 1;
-		end = strstr(start, " ");
+	char *cursor = lines[1];
+	const char *end = lines[1] + BUFFER_SIZE - 1;
+	cursor = append_chars(cursor, end, month_name, strlen(month_name));
+	if (width <= LINE_APPEND_LIMIT) {
+		cursor = append_chars(cursor, end, " ", 1);
+		*append_chars(cursor, end, number, strlen(number)) = '\0';
+	} else {
+		*cursor = '\0';
+		*append_chars(lines[2], lines[2] + BUFFER_SIZE - 1, number, strlen(number)) = '\0';
 	}
 }
 
-// Update screen based on new time
-static void display_time(struct tm *tm)
+// Index of the five minute phrase bucket for the given time of day. Phrases
+// switch halfway between five minute marks, matching time_to_template.
+static int phrase_bucket(int hours, int minutes, int seconds)
 {
+	const int half_mins = (hours * 60 + minutes) * 2 + seconds / 30;
+	return ((half_mins + 5) / 10) % PHRASE_BUCKETS;
+}
 
-  // The current time text will be stored in the following strings
-  char textLine[NUM_LINES][BUFFER_SIZE];
-  char format[NUM_LINES];
+// Time phrase for the given bucket, built only when it is not cached yet
+static const Phrase *time_phrase(int bucket, int hours, int minutes, int seconds)
+{
+	if (bucket != cached_phrase_bucket) {
+		time_to_lines(hours, minutes, seconds, cached_phrase.text, cached_phrase.format);
+		layoutPhrase(&cached_phrase);
+		cached_phrase_bucket = bucket;
+	}
+	return &cached_phrase;
+}
 
-	update_top_time_buffer(t);
+// Build the phrase following the one on screen while nothing else is going on
+static void phrase_precompute_handler(void *context)
+{
+	phrase_precompute_timer = NULL;
+	if (shown_phrase_bucket < 0) {
+		return;
+	}
+
+	const int day_seconds = 24 * 60 * 60;
+	const int next_bucket = (shown_phrase_bucket + 1) % PHRASE_BUCKETS;
+	// A bucket starts half a bucket before its five minute mark
+	const int start = (next_bucket * PHRASE_BUCKET_SECONDS - PHRASE_BUCKET_SECONDS / 2 + day_seconds) % day_seconds;
+	time_phrase(next_bucket, start / 3600, (start / 60) % 60, start % 60);
+}
+
+static void schedule_phrase_precompute(void)
+{
+	if (phrase_precompute_timer) {
+		app_timer_reschedule(phrase_precompute_timer, PHRASE_PRECOMPUTE_DELAY_MS);
+	} else {
+		phrase_precompute_timer = app_timer_register(PHRASE_PRECOMPUTE_DELAY_MS, phrase_precompute_handler, NULL);
+	}
+}
+
+// Drop the cached phrase after a change that affects how phrases are built
+static void invalidate_phrase_cache(void)
+{
+	cached_phrase_bucket = -1;
+	if (shown_phrase_bucket >= 0) {
+		schedule_phrase_precompute();
+	}
+}
+
+// Top bar time and bottom date and glucose, refreshed every minute
+static void update_status(void)
+{
+	if (t->tm_min % power->top_refresh_minutes == 0) {
+		update_top_time_buffer(t);
+	}
 	update_bottom_status(t);
-  
-  if (showTime || dateTimeout > 1) {
-  	time_to_lines(t->tm_hour, t->tm_min, t->tm_sec, textLine, format);
-    dateTimeout = 0;
-    showTime = true;
+}
+
+// Update the phrase (or date) based on new time
+static void display_time(struct tm *tm)
+{
+	PROFILE_SCOPE(PROFILE_DISPLAY_TIME);
+	const Phrase *phrase;
+
+  if (showTime) {
+    const int bucket = phrase_bucket(t->tm_hour, t->tm_min, t->tm_sec);
+    if (bucket == shown_phrase_bucket) {
+      // Same fuzzy phrase as on screen, nothing to animate
+      return;
+    }
+    phrase = time_phrase(bucket, t->tm_hour, t->tm_min, t->tm_sec);
+    shown_phrase_bucket = bucket;
   } else {
-    date_to_lines(t->tm_wday, t->tm_mday, t->tm_mon, textLine, format);
+    date_to_lines(t->tm_wday, t->tm_mday, t->tm_mon, date_phrase.text, date_phrase.format);
+    layoutPhrase(&date_phrase);
+    phrase = &date_phrase;
+    shown_phrase_bucket = -1;
   }
-  
-  int nextNLines = configureLayersForText(textLine, format);
+
+  // Layers of a transition still in flight are about to be reconfigured
+  cancelTransition();
+  configureLayersForPhrase(phrase);
 
   int delay = 0;
   for (int i = 0; i < NUM_LINES; i++) {
-    if (nextNLines != currentNLines || needToUpdateLine(&lines[i], textLine[i])) {
-      updateLineTo(&lines[i], textLine[i], delay);
+    if (phrase->numLines != currentNLines || needToUpdateLine(&lines[i], phrase->text[i])) {
+      updateLineTo(&lines[i], phrase->text[i], delay);
       delay += ANIMATION_STAGGER_TIME;
     }
   }
 
-  currentNLines = nextNLines;
+  currentNLines = phrase->numLines;
+
+  // Hold deferred work (glucose, icons, flash writes) until the slides end
+  work_queue_hold(transitionRunning());
+#if DEBUG
+  if (transitionRunning() && !transition_start_ms) {
+    transition_start_ms = profiler_now_ms();
+  }
+#endif
+
+  if (showTime) {
+    schedule_phrase_precompute();
+  }
 }
 
-static void tap_handler(AccelAxisType axis, int32_t direction)
+// Refresh our copy of the current time
+static void refresh_current_time(void)
 {
-  // Get fresh time data and copy it to our storage
   time_t raw_time;
   time(&raw_time);
   struct tm *temp_time = localtime(&raw_time);
   if (temp_time) {
     current_time = *temp_time;  // Copy the data
   }
+}
+
+// Milliseconds until the next phrase bucket starts, half a bucket before
+// each five minute mark (xx:02:30, xx:07:30, ...)
+static uint32_t ms_until_phrase_flip(void)
+{
+	time_t now_s;
+	uint16_t now_ms;
+	time_ms(&now_s, &now_ms);
+	struct tm *now = localtime(&now_s);
+	if (!now) {
+		return PHRASE_BUCKET_SECONDS * 1000;
+	}
+
+	const int day_seconds = now->tm_hour * 3600 + now->tm_min * 60 + now->tm_sec;
+	const int into_bucket = (day_seconds + PHRASE_BUCKET_SECONDS / 2) % PHRASE_BUCKET_SECONDS;
+	return (PHRASE_BUCKET_SECONDS - into_bucket) * 1000 - now_ms + PHRASE_FLIP_MARGIN_MS;
+}
+
+static void schedule_phrase_flip(void);
+
+// The only regular caller of the phrase pipeline; fires once per bucket
+static void phrase_flip_handler(void *context)
+{
+	phrase_flip_timer = NULL;
+	refresh_current_time();
+	display_time(t);
+	schedule_phrase_flip();
+}
+
+static void schedule_phrase_flip(void)
+{
+	const uint32_t delay = ms_until_phrase_flip();
+	if (phrase_flip_timer) {
+		app_timer_reschedule(phrase_flip_timer, delay);
+	} else {
+		phrase_flip_timer = app_timer_register(delay, phrase_flip_handler, NULL);
+	}
+}
+
+static void date_timeout_handler(void *context)
+{
+  date_timeout_timer = NULL;
+  if (showTime) {
+    return;
+  }
+
+  refresh_current_time();
+  showTime = true;
+  display_time(t);
+}
+
+static void tap_coalesce_handler(void *context)
+{
+  tap_coalesce_timer = NULL;
+}
+
+static void tap_handler(AccelAxisType axis, int32_t direction)
+{
+  // A tap burst (shaking, bumping the wrist) toggles the view only once
+  if (tap_coalesce_timer) {
+    return;
+  }
+  PROFILE_SCOPE(PROFILE_TAP);
+  tap_coalesce_timer = app_timer_register(TAP_COALESCE_MS, tap_coalesce_handler, NULL);
+  power_ledger_count(LEDGER_TAPS, 1);
+
+  refresh_current_time();
   
   showTime = !showTime;
+  invalidate_phrase_cache();
+  if (showTime) {
+    if (date_timeout_timer) {
+      app_timer_cancel(date_timeout_timer);
+      date_timeout_timer = NULL;
+    }
+  } else {
+    date_timeout_timer = app_timer_register(DATE_DISPLAY_TIMEOUT_MS, date_timeout_handler, NULL);
+  }
   display_time(t);
 }
 
+static int auto_power_mode(void)
+{
+	if (t->tm_hour >= QUIET_START_HOUR || t->tm_hour < QUIET_END_HOUR) {
+		return POWER_NIGHT;
+	}
+	if (!current_battery_state.is_charging) {
+		const int threshold = (power_mode == POWER_SAVER) ? SAVER_EXIT_BATTERY_PERCENT : SAVER_BATTERY_PERCENT;
+		if (current_battery_state.charge_percent <= threshold) {
+			return POWER_SAVER;
+		}
+	}
+	return POWER_FULL;
+}
+
+// Pick the power profile for the current setting, time and battery and
+// apply the parts that need services (re)subscribed
+static void update_power_profile(void)
+{
+	const int mode = (power_setting == POWER_AUTO) ? auto_power_mode() : power_setting;
+	if (mode < POWER_FULL || mode > POWER_NIGHT) {
+		return;
+	}
+	if (mode != power_mode) {
+		LOG_INFO("Power profile %d -> %d", power_mode, mode);
+		power_mode = mode;
+		power = &POWER_PROFILES[mode];
+	}
+	pebble_messenger_set_request_scale(power->request_scale);
+
+	if (power->taps && !taps_subscribed) {
+		// Sample as little as often to save battery and no need for precision
+		accel_service_set_sampling_rate(ACCEL_SAMPLING_10HZ);
+		accel_tap_service_subscribe(tap_handler);
+		taps_subscribed = true;
+	} else if (!power->taps && taps_subscribed) {
+		accel_tap_service_unsubscribe();
+		taps_subscribed = false;
+	}
+}
+
 static void initLineForStart(Line* line)
 {
 	// Switch current and next layer
@@ -775,11 +1340,8 @@ static void initLineForStart(Line* line)
 // Update screen without animation first time we start the watchface
 static void display_initial_time(struct tm *t)
 {
-	// The current time text will be stored in the following strings
-	char textLine[NUM_LINES][BUFFER_SIZE];
-	char format[NUM_LINES];
-
-	time_to_lines(t->tm_hour, t->tm_min, t->tm_sec, textLine, format);
+	const int bucket = phrase_bucket(t->tm_hour, t->tm_min, t->tm_sec);
+	const Phrase *phrase = time_phrase(bucket, t->tm_hour, t->tm_min, t->tm_sec);
 	update_top_time_buffer(t);
 	update_bottom_status(t);
 	
@@ -798,56 +1360,100 @@ static void display_initial_time(struct tm *t)
 	}
 
 	// This configures the nextLayer for each line
-	currentNLines = configureLayersForText(textLine, format);
+	configureLayersForPhrase(phrase);
+	currentNLines = phrase->numLines;
 
 	// Set the text and configure layers to the start position
 	for (int i = 0; i < currentNLines; i++)
 	{
-		updateLayerText(&lines[i], lines[i].nextLayer, textLine[i]);
+		updateLayerText(&lines[i], lines[i].nextLayer, phrase->text[i]);
 		// This call switches current- and nextLayer
 		initLineForStart(&lines[i]);
-	}	
+	}
+
+	shown_phrase_bucket = bucket;
+	schedule_phrase_precompute();
+	schedule_phrase_flip();
 }
 
 // Time handler called every minute by the system
+// Deferred: the request goes out after the tick's transition
+static void request_glucose_job(void *context)
+{
+	pebble_messenger_request_glucose();
+}
+
 static void handle_minute_tick(struct tm *tick_time, TimeUnits units_changed)
 {
+	PROFILE_SCOPE(PROFILE_MINUTE_TICK);
+#if DEBUG
+	// Soak mode owns the clock
+	if (soak_timer) {
+		return;
+	}
+#endif
 	// Copy time data to our storage (tick_time points to static buffer that can be overwritten)
 	if (tick_time) {
 		current_time = *tick_time;
 	}
   
-  if (!showTime) {
-    dateTimeout++;
-  }
-  
-	display_time(t);
+	// Quiet hours start and end on a tick
+	update_power_profile();
+
+	// Next patient; all their readings came in one message, so no request
+	if (pebble_messenger_patient_count() > 1) {
+		shown_patient = (shown_patient + 1) % pebble_messenger_patient_count();
+	}
+
+	update_status();
+
+	// Phrases change on the flip timer; a tick only catches clock changes
+	if (showTime && phrase_bucket(t->tm_hour, t->tm_min, t->tm_sec) != shown_phrase_bucket) {
+		display_time(t);
+		schedule_phrase_flip();
+	}
+	
+	// Request glucose data every 5 minutes (at 0, 5, 10, 15, 20, etc.), or every
+	// 10 while the display projects values between readings, stretched further
+	// by the power profile. Also request if we don't have valid data (messenger
+	// will handle throttling)
+	const int interval = pebble_messenger_request_interval_minutes();
+	bool should_request = (t->tm_min % interval == 0);
 	
-	// Request glucose data every 5 minutes (at 0, 5, 10, 15, 20, etc.)
-	// Also request if we don't have valid data (messenger will handle throttling)
-	bool should_request = (t->tm_min % 5 == 0);
+	// Nothing to schedule while disconnected; reconnecting triggers a catch-up request
+	if (!pebble_messenger_is_connected()) {
+		return;
+	}
 	
-	// If we don't have glucose data, try more frequently (every minute)
-	// The messenger's throttle will prevent actual spam
+	// If we don't have glucose data, try more frequently at first
 	if (!pebble_messenger_has_glucose_data()) {
-		should_request = true;
-		APP_LOG(APP_LOG_LEVEL_DEBUG, "No valid glucose data, requesting...");
+		const int retry = no_data_requests < NO_DATA_QUICK_RETRIES ? power->request_scale : interval;
+		should_request = (t->tm_min % retry == 0);
+		if (should_request) {
+			no_data_requests++;
+			LOG_DEBUG("No valid glucose data, requesting...");
+		}
+	} else {
+		no_data_requests = 0;
 	}
 	
 	if (should_request) {
-		pebble_messenger_request_glucose();
+		work_queue_defer(request_glucose_job, NULL);
 	}
 }
 
 /**
- * Debug methods. For quickly debugging enable debug macro on top to transform the watchface into
- * a standard app and you will be able to change the time with the up and down buttons
+ * Debug methods. DEBUG=1 builds install as a standard app (see wscript), so the buttons reach
+ * them: up and down change the time, select shows the overlay and a long select dumps the stats
  */
 #if DEBUG
 
-static void up_single_click_handler(ClickRecognizerRef recognizer, Window *window) {
+static TextLayer *debug_overlay_layer = NULL;
+static char debug_overlay_buffer[256];
+
+static void up_single_click_handler(ClickRecognizerRef recognizer, void *context) {
 	(void)recognizer;
-	(void)window;
+	(void)context;
 	
 	t->tm_min += 5;
 	if (t->tm_min >= 60) {
@@ -858,13 +1464,14 @@ static void up_single_click_handler(ClickRecognizerRef recognizer, Window *windo
 			t->tm_hour = 0;
 		}
 	}
+	update_status();
 	display_time(t);
 }
 
 
-static void down_single_click_handler(ClickRecognizerRef recognizer, Window *window) {
+static void down_single_click_handler(ClickRecognizerRef recognizer, void *context) {
 	(void)recognizer;
-	(void)window;
+	(void)context;
 	
 	t->tm_min -= 5;
 	if (t->tm_min < 0) {
@@ -875,123 +1482,191 @@ static void down_single_click_handler(ClickRecognizerRef recognizer, Window *win
 			t->tm_hour = 23;
 		}
 	}
+	update_status();
+	display_time(t);
+}
+
+// Show or hide the latency and heap overlay
+static void select_single_click_handler(ClickRecognizerRef recognizer, void *context) {
+	if (debug_overlay_layer) {
+		text_layer_destroy(debug_overlay_layer);
+		debug_overlay_layer = NULL;
+		return;
+	}
+
+	// Data age: now, and when drawn last/avg/max since launch
+	DataAgeStats age;
+	pebble_messenger_get_data_age(&age);
+	const int length = snprintf(debug_overlay_buffer, sizeof(debug_overlay_buffer), "age %ld drawn %ld/%ld/%lds\n",
+		(long)age.current_s, (long)age.last_s, age.count ? (long)(age.total_s / age.count) : 0L, (long)age.max_s);
+	profiler_format(debug_overlay_buffer + length, sizeof(debug_overlay_buffer) - length);
+	Layer *window_layer = window_get_root_layer(window);
+	debug_overlay_layer = text_layer_create(layer_get_bounds(window_layer));
+	text_layer_set_font(debug_overlay_layer, fonts_get_system_font(FONT_KEY_GOTHIC_14));
+	text_layer_set_text(debug_overlay_layer, debug_overlay_buffer);
+	layer_add_child(window_layer, text_layer_get_layer(debug_overlay_layer));
+}
+
+// Dump all stats to the log
+static void select_long_click_handler(ClickRecognizerRef recognizer, void *context) {
+	profiler_dump();
+}
+
+static void apply_setting(uint32_t key, int value);
+
+static void soak_log(void)
+{
+	LOG_INFO("Soak %lu steps, day %lu: heap used=%u free=%u, failed animations=%u",
+		(unsigned long)soak_iterations, (unsigned long)(soak_iterations * SOAK_STEP_SECONDS / (24 * 60 * 60)),
+		(unsigned)heap_bytes_used(), (unsigned)heap_bytes_free(), failed_animations);
+	if (transition_count > 0 || transition_cancelled > 0) {
+		LOG_INFO("Soak transitions: n=%u avg=%lu max=%lu ms, cancelled=%u", transition_count,
+			(unsigned long)(transition_count ? transition_total_ms / transition_count : 0),
+			(unsigned long)transition_max_ms, transition_cancelled);
+	}
+	profiler_dump();
+	transition_count = 0;
+	transition_cancelled = 0;
+	transition_total_ms = 0;
+	transition_max_ms = 0;
+}
+
+// One step of accelerated time; every few steps exercises another path
+static void soak_step(void *context)
+{
+	soak_timer = app_timer_register(SOAK_STEP_MS, soak_step, NULL);
+	soak_iterations++;
+	soak_seconds = (soak_seconds + SOAK_STEP_SECONDS) % (24 * 60 * 60);
+	t->tm_hour = soak_seconds / 3600;
+	t->tm_min = (soak_seconds / 60) % 60;
+	t->tm_sec = soak_seconds % 60;
+	update_status();
 	display_time(t);
+
+	switch (soak_iterations % 16) {
+	case 3:
+		apply_setting(LANGUAGE_KEY, (lang + 1) % (SV + 1));
+		break;
+	case 6:
+		apply_setting(TEXT_ALIGN_KEY, (text_align + 1) % 3);
+		break;
+	case 9:
+		apply_setting(INVERT_KEY, invert ? 0 : 1);
+		break;
+	case 11:
+	case 13:
+		// Date and back again, two steps apart to clear the tap coalescing
+		tap_handler(ACCEL_AXIS_Z, 1);
+		break;
+	case 14:
+		pebble_messenger_inject_glucose(60 + (soak_iterations * 7) % 240, 1 + soak_iterations % 5);
+		break;
+	}
+
+	if (soak_iterations % SOAK_LOG_EVERY == 0) {
+		soak_log();
+	}
 }
 
-static void click_config_provider(ClickConfig **config, Window *window) {
-  (void)window;
+// Start or stop soak mode; stopping restores the settings and real time
+static void down_long_click_handler(ClickRecognizerRef recognizer, void *context)
+{
+	static int saved_align, saved_lang;
+	static bool saved_invert;
+
+	if (soak_timer) {
+		app_timer_cancel(soak_timer);
+		soak_timer = NULL;
+		soak_log();
+		apply_setting(TEXT_ALIGN_KEY, saved_align);
+		apply_setting(LANGUAGE_KEY, saved_lang);
+		apply_setting(INVERT_KEY, saved_invert ? 1 : 0);
+		refresh_current_time();
+		update_status();
+		display_time(t);
+		schedule_phrase_flip();
+		LOG_INFO("Soak stopped");
+		return;
+	}
 
-  config[BUTTON_ID_UP]->click.handler = (ClickHandler) up_single_click_handler;
-  config[BUTTON_ID_UP]->click.repeat_interval_ms = 100;
+	saved_align = text_align;
+	saved_lang = lang;
+	saved_invert = invert;
+	soak_iterations = 0;
+	soak_seconds = t->tm_hour * 3600 + t->tm_min * 60 + t->tm_sec;
+	if (phrase_flip_timer) {
+		app_timer_cancel(phrase_flip_timer);
+		phrase_flip_timer = NULL;
+	}
+	LOG_INFO("Soak started: %d s per %d ms step", SOAK_STEP_SECONDS, SOAK_STEP_MS);
+	soak_timer = app_timer_register(SOAK_STEP_MS, soak_step, NULL);
+}
 
-  config[BUTTON_ID_DOWN]->click.handler = (ClickHandler) down_single_click_handler;
-  config[BUTTON_ID_DOWN]->click.repeat_interval_ms = 100;
+static void click_config_provider(void *context) {
+  window_single_repeating_click_subscribe(BUTTON_ID_UP, 100, up_single_click_handler);
+  window_single_repeating_click_subscribe(BUTTON_ID_DOWN, 100, down_single_click_handler);
+  window_single_click_subscribe(BUTTON_ID_SELECT, select_single_click_handler);
+  window_long_click_subscribe(BUTTON_ID_SELECT, 0, select_long_click_handler, NULL);
+  window_long_click_subscribe(BUTTON_ID_DOWN, 0, down_long_click_handler, NULL);
 }
 
 #endif
 
 static void sync_error_callback(DictionaryResult dict_error, AppMessageResult app_message_error, void *context)
 {
-	APP_LOG(APP_LOG_LEVEL_DEBUG, "App Message Sync Error: %d", app_message_error);
+	LOG_DEBUG("App Message Sync Error: %d", app_message_error);
 }
 
-static void sync_tuple_changed_callback(const uint32_t key, const Tuple* new_tuple, const Tuple* old_tuple, void* context) {
-    GTextAlignment alignment;
-    
-    // Handle TEXT_ALIGN_KEY
-    if (key == TEXT_ALIGN_KEY) {
-        text_align = new_tuple->value->uint8;
-        persist_write_int(TEXT_ALIGN_KEY, text_align);
-        APP_LOG(APP_LOG_LEVEL_DEBUG, "Set text alignment: %u", text_align);
-
-        alignment = lookup_text_alignment(text_align);
-        for (int i = 0; i < NUM_LINES; i++)
-        {
-            text_layer_set_text_alignment(lines[i].currentLayer, alignment);
-            text_layer_set_text_alignment(lines[i].nextLayer, alignment);
-            layer_mark_dirty(text_layer_get_layer(lines[i].currentLayer));
-            layer_mark_dirty(text_layer_get_layer(lines[i].nextLayer));
-        }
-        if (t) {
-            update_top_time_buffer(t);
-            update_bottom_status(t);
-        }
-        if (top_info_layer) {
-            layer_mark_dirty(top_info_layer);
-        }
-        if (bottom_date_layer) {
-            layer_mark_dirty(text_layer_get_layer(bottom_date_layer));
-        }
-        if (bottom_info_layer) {
-            layer_mark_dirty(text_layer_get_layer(bottom_info_layer));
-        }
-        if (bottom_arrow_layer) {
-            layer_mark_dirty(bottom_arrow_layer);
-        }
-    }
-    // Handle INVERT_KEY
-    else if (key == INVERT_KEY) {
-        invert = new_tuple->value->uint8 == 1;
-        persist_write_bool(INVERT_KEY, invert);
-        APP_LOG(APP_LOG_LEVEL_DEBUG, "Set invert: %u", invert ? 1 : 0);
-        
-        // Update text layer colors for all lines
-        GColor text_color = invert ? GColorBlack : GColorWhite;
-        for (int i = 0; i < NUM_LINES; i++) {
-            text_layer_set_text_color(lines[i].currentLayer, text_color);
-            text_layer_set_text_color(lines[i].nextLayer, text_color);
-            layer_mark_dirty(text_layer_get_layer(lines[i].currentLayer));
-            layer_mark_dirty(text_layer_get_layer(lines[i].nextLayer));
-        }
-        
-        if (inverter_layer) {
-            layer_set_hidden(inverter_layer, !invert);
-            layer_mark_dirty(inverter_layer);
-        }
-        if (t) {
-            update_top_time_buffer(t);
-            update_bottom_status(t);
-        }
-        if (top_info_layer) {
-            layer_mark_dirty(top_info_layer);
-        }
-        apply_bottom_theme();
-        if (bottom_date_layer) {
-            layer_mark_dirty(text_layer_get_layer(bottom_date_layer));
-        }
-        if (bottom_info_layer) {
-            layer_mark_dirty(text_layer_get_layer(bottom_info_layer));
-        }
-        if (bottom_arrow_layer) {
-            layer_mark_dirty(bottom_arrow_layer);
-        }
-    }
-    // Handle LANGUAGE_KEY
-    else if (key == LANGUAGE_KEY) {
-        lang = (Language) new_tuple->value->uint8;
-        persist_write_int(LANGUAGE_KEY, lang);
-        APP_LOG(APP_LOG_LEVEL_DEBUG, "Set language: %u", lang);
+// FNV-1a over the (key, value) pairs in key order, as settingsHash in index.js
+static uint32_t settings_hash(void)
+{
+	const int values[] = {
+		[INVERT_KEY] = invert ? 1 : 0,
+		[TEXT_ALIGN_KEY] = text_align,
+		[LANGUAGE_KEY] = lang,
+		[ESTIMATE_KEY] = estimate_glucose ? 1 : 0,
+		[POWER_KEY] = power_setting
+	};
+	uint32_t hash = 2166136261u;
+	for (int key = 0; key < (int)ARRAY_LENGTH(values); key++) {
+		hash = (hash ^ (uint8_t)key) * 16777619u;
+		hash = (hash ^ (uint8_t)values[key]) * 16777619u;
+	}
+	return hash;
+}
 
-        if (t)
-        {
-            display_time(t);
-        }
+// Deferred: a settings message changes several keys at once, written together
+static void save_settings_job(void *context) {
+#if DEBUG
+    // Soak mode cycles settings every few seconds and restores them at the end
+    if (soak_timer) {
+        return;
     }
+#endif
+    persist_write_int(TEXT_ALIGN_KEY, text_align);
+    persist_write_bool(INVERT_KEY, invert);
+    persist_write_int(LANGUAGE_KEY, lang);
+    persist_write_bool(ESTIMATE_KEY, estimate_glucose);
+    persist_write_int(POWER_KEY, power_setting);
+    power_ledger_count(LEDGER_PERSIST_WRITES, 5);
+    pebble_messenger_set_settings_hash(settings_hash());
 }
 
-// Callback for settings received directly from phone (bypasses AppSync)
-// This is called by the messenger when settings arrive
-static void settings_received_callback(uint32_t key, int value) {
+// Apply a setting from the phone. Values the face already uses are skipped,
+// so the initial AppSync round and repeated transmissions cost nothing.
+static void apply_setting(uint32_t key, int value) {
     GTextAlignment alignment;
     
-    APP_LOG(APP_LOG_LEVEL_INFO, "Settings received: key=%lu, value=%d", (unsigned long)key, value);
-    
     // Handle TEXT_ALIGN_KEY
     if (key == TEXT_ALIGN_KEY) {
+        if (value == text_align) {
+            return;
+        }
         text_align = value;
-        persist_write_int(TEXT_ALIGN_KEY, text_align);
-        APP_LOG(APP_LOG_LEVEL_DEBUG, "Set text alignment: %d", text_align);
+        work_queue_defer(save_settings_job, NULL);
+        LOG_DEBUG("Set text alignment: %d", text_align);
 
+        invalidate_phrase_cache();
         alignment = lookup_text_alignment(text_align);
         for (int i = 0; i < NUM_LINES; i++)
         {
@@ -1000,28 +1675,15 @@ static void settings_received_callback(uint32_t key, int value) {
             layer_mark_dirty(text_layer_get_layer(lines[i].currentLayer));
             layer_mark_dirty(text_layer_get_layer(lines[i].nextLayer));
         }
-        if (t) {
-            update_top_time_buffer(t);
-            update_bottom_status(t);
-        }
-        if (top_info_layer) {
-            layer_mark_dirty(top_info_layer);
-        }
-        if (bottom_date_layer) {
-            layer_mark_dirty(text_layer_get_layer(bottom_date_layer));
-        }
-        if (bottom_info_layer) {
-            layer_mark_dirty(text_layer_get_layer(bottom_info_layer));
-        }
-        if (bottom_arrow_layer) {
-            layer_mark_dirty(bottom_arrow_layer);
-        }
     }
     // Handle INVERT_KEY
     else if (key == INVERT_KEY) {
+        if ((value == 1) == invert) {
+            return;
+        }
         invert = (value == 1);
-        persist_write_bool(INVERT_KEY, invert);
-        APP_LOG(APP_LOG_LEVEL_DEBUG, "Set invert: %u", invert ? 1 : 0);
+        work_queue_defer(save_settings_job, NULL);
+        LOG_DEBUG("Set invert: %u", invert ? 1 : 0);
         
         // Update text layer colors for all lines
         GColor text_color = invert ? GColorBlack : GColorWhite;
@@ -1036,10 +1698,6 @@ static void settings_received_callback(uint32_t key, int value) {
             layer_set_hidden(inverter_layer, !invert);
             layer_mark_dirty(inverter_layer);
         }
-        if (t) {
-            update_top_time_buffer(t);
-            update_bottom_status(t);
-        }
         if (top_info_layer) {
             layer_mark_dirty(top_info_layer);
         }
@@ -1050,21 +1708,81 @@ static void settings_received_callback(uint32_t key, int value) {
         if (bottom_info_layer) {
             layer_mark_dirty(text_layer_get_layer(bottom_info_layer));
         }
-        if (bottom_arrow_layer) {
-            layer_mark_dirty(bottom_arrow_layer);
-        }
     }
     // Handle LANGUAGE_KEY
     else if (key == LANGUAGE_KEY) {
+        if (value == (int) lang) {
+            return;
+        }
         lang = (Language) value;
-        persist_write_int(LANGUAGE_KEY, lang);
-        APP_LOG(APP_LOG_LEVEL_DEBUG, "Set language: %d", lang);
+        work_queue_defer(save_settings_job, NULL);
+        LOG_DEBUG("Set language: %d", lang);
+        invalidate_phrase_cache();
+        shown_phrase_bucket = -1;
 
         if (t)
         {
             display_time(t);
         }
     }
+    // Handle ESTIMATE_KEY
+    else if (key == ESTIMATE_KEY) {
+        if ((value == 1) == estimate_glucose) {
+            return;
+        }
+        estimate_glucose = (value == 1);
+        work_queue_defer(save_settings_job, NULL);
+        LOG_DEBUG("Set estimate: %u", estimate_glucose ? 1 : 0);
+
+        pebble_messenger_set_estimation_enabled(estimate_glucose);
+        update_glucose_display();
+    }
+    // Handle POWER_KEY
+    else if (key == POWER_KEY) {
+        if (value == power_setting) {
+            return;
+        }
+        power_setting = value;
+        work_queue_defer(save_settings_job, NULL);
+        LOG_DEBUG("Set power profile: %d", power_setting);
+
+        update_power_profile();
+    }
+}
+
+static void sync_tuple_changed_callback(const uint32_t key, const Tuple* new_tuple, const Tuple* old_tuple, void* context) {
+    PROFILE_SCOPE(PROFILE_SETTINGS);
+    apply_setting(key, new_tuple->value->uint8);
+}
+
+// Callback for settings received directly from phone (bypasses AppSync)
+// This is called by the messenger when settings arrive
+static void settings_received_callback(uint32_t key, int value) {
+    PROFILE_SCOPE(PROFILE_SETTINGS);
+    LOG_INFO("Settings received: key=%lu, value=%d", (unsigned long)key, value);
+    apply_setting(key, value);
+}
+
+// Read the settings persisted by apply_setting, before anything is drawn
+static void load_settings(void)
+{
+	if (persist_exists(TEXT_ALIGN_KEY)) {
+		text_align = persist_read_int(TEXT_ALIGN_KEY);
+	}
+	if (persist_exists(INVERT_KEY)) {
+		invert = persist_read_bool(INVERT_KEY);
+	}
+	if (persist_exists(LANGUAGE_KEY)) {
+		lang = persist_read_int(LANGUAGE_KEY);
+	}
+	if (persist_exists(ESTIMATE_KEY)) {
+		estimate_glucose = persist_read_bool(ESTIMATE_KEY);
+	}
+	if (persist_exists(POWER_KEY)) {
+		power_setting = persist_read_int(POWER_KEY);
+	}
+	pebble_messenger_set_estimation_enabled(estimate_glucose);
+	pebble_messenger_set_settings_hash(settings_hash());
 }
 
 static void init_line(Line* line)
@@ -1128,15 +1846,18 @@ static void window_load(Window *window)
 
 	const int bottom_text_height = 17;
 	const int bottom_text_y = bottom_y + (BOTTOM_TEXT_RESERVE - bottom_text_height) / 2 - 4;
-	bottom_date_layer = text_layer_create(GRect(4, bottom_text_y, bounds.size.w / 2, bottom_text_height));
+	bottom_date_layer = text_layer_create(GRect(4, bottom_text_y, BOTTOM_DATE_WIDTH, bottom_text_height));
 	text_layer_set_background_color(bottom_date_layer, GColorClear);
 	text_layer_set_font(bottom_date_layer, fonts_get_system_font(FONT_KEY_GOTHIC_18));
 	text_layer_set_text_alignment(bottom_date_layer, GTextAlignmentLeft);
 	layer_set_clips(text_layer_get_layer(bottom_date_layer), false);
 	layer_add_child(window_layer, text_layer_get_layer(bottom_date_layer));
 
-	const int arrow_x = bounds.size.w - BOTTOM_ARROW_WIDTH - 4;
-	GRect info_frame = GRect(bounds.size.w / 2, bottom_text_y, arrow_x - (bounds.size.w / 2) - 4, bottom_text_height);
+	// The info text takes everything between the date and the arrow (which
+	// pads itself): "AB ~123", about 50 px, must fit on one line
+	const int arrow_x = bounds.size.w - BOTTOM_ARROW_WIDTH - 2;
+	const int info_x = 4 + BOTTOM_DATE_WIDTH;
+	GRect info_frame = GRect(info_x, bottom_text_y, arrow_x - info_x, bottom_text_height);
 	if (info_frame.size.w < 10) {
 		info_frame.size.w = 10;
 	}
@@ -1153,34 +1874,21 @@ static void window_load(Window *window)
 
 	apply_bottom_theme();
 
-
-
-	// Configure time on init - copy to our storage
-	time_t raw_time;
-
-	time(&raw_time);
-	struct tm *temp_time = localtime(&raw_time);
-	if (temp_time) {
-		current_time = *temp_time;
-	}
-
+	// Settings and the last glucose reading are loaded already, so the first
+	// frame is built exactly once with its final content
+	refresh_current_time();
 	display_initial_time(t);
+	LOG_DEBUG("First frame built %lu ms after launch", (unsigned long)ms_since_launch());
+	PROFILE_HEAP(HEAP_WINDOW_LOAD);
 
-	// Load persisted settings before AppSync init
-	if (persist_exists(TEXT_ALIGN_KEY)) {
-		text_align = persist_read_int(TEXT_ALIGN_KEY);
-	}
-	if (persist_exists(INVERT_KEY)) {
-		invert = persist_read_bool(INVERT_KEY);
-	}
-	if (persist_exists(LANGUAGE_KEY)) {
-		lang = persist_read_int(LANGUAGE_KEY);
-	}
-
+	// AppSync reports the initial values back through the changed callback;
+	// apply_setting ignores them as they match what is on screen already
 	Tuplet initial_values[] = {
 		TupletInteger(TEXT_ALIGN_KEY, text_align),        // Persistierter Wert
 		TupletInteger(INVERT_KEY, invert ? 1 : 0),       // Persistierter Wert
-		TupletInteger(LANGUAGE_KEY, lang)                // Persistierter Wert
+		TupletInteger(LANGUAGE_KEY, lang),               // Persistierter Wert
+		TupletInteger(ESTIMATE_KEY, estimate_glucose ? 1 : 0),  // Persistierter Wert
+		TupletInteger(POWER_KEY, power_setting)          // Persistierter Wert
 	};
 
 	app_sync_init(&sync, sync_buffer, sizeof(sync_buffer), initial_values, ARRAY_LENGTH(initial_values),
@@ -1195,6 +1903,16 @@ static void window_unload(Window *window)
 {
 	app_sync_deinit(&sync);
 
+	// Animations must not outlive the layers they move
+	cancelTransition();
+
+#if DEBUG
+	if (debug_overlay_layer) {
+		text_layer_destroy(debug_overlay_layer);
+		debug_overlay_layer = NULL;
+	}
+#endif
+
 	// Free layers
 	if (inverter_layer) {
 		layer_destroy(inverter_layer);
@@ -1233,44 +1951,21 @@ static void window_unload(Window *window)
 }
 
 static void handle_init() {
-	// Settings loaded in window_load before AppSync init
+	time_ms(&launch_time_s, &launch_time_ms);
+	power_ledger_init();
 
-	// Get current time immediately for buffer initialization and copy to our storage
-	time_t raw_time;
-	time(&raw_time);
-	struct tm *init_time = localtime(&raw_time);
-	if (init_time) {
-		current_time = *init_time;  // Copy to our storage
-	}
-	
-	// Initialize time buffer with actual current time (not placeholder)
-	const char *format = clock_is_24h_style() ? "%H:%M" : "%I:%M";
-	if (strftime(top_time_buffer, sizeof(top_time_buffer), format, t) == 0) {
-		snprintf(top_time_buffer, sizeof(top_time_buffer), "--:--");
-	}
-	if (!clock_is_24h_style() && top_time_buffer[0] == '0') {
-		memmove(top_time_buffer, top_time_buffer + 1, sizeof(top_time_buffer) - 1);
-	}
-	
-	// Initialize date buffer with actual current date
-	if (strftime(bottom_date_buffer, sizeof(bottom_date_buffer), "%d.%m.%Y", t) == 0) {
-		snprintf(bottom_date_buffer, sizeof(bottom_date_buffer), "--.--.----");
-	}
-	
-	// Glucose info starts empty until we receive data
-	snprintf(bottom_info_buffer, sizeof(bottom_info_buffer), "---");
-	bottom_trend_direction = TREND_UNKNOWN;
+	// Everything the first frame depends on is loaded before the window is
+	// pushed; window_load then builds it once (top/bottom buffers included)
+	load_settings();
 	
 	current_battery_state = battery_state_service_peek();
-	bluetooth_connected = connection_service_peek_pebble_app_connection();
 	battery_state_service_subscribe(battery_state_handler);
-	connection_service_subscribe((ConnectionHandlers) {
-		.pebble_app_connection_handler = bluetooth_handler
-	});
 
-	// Initialize messenger with callbacks for receiving glucose data and settings
-	// Note: Must be called BEFORE app_message_open()
-	pebble_messenger_init(glucose_data_received_callback, settings_received_callback);
+	// Initialize messenger with callbacks for receiving glucose data, settings
+	// and connection changes (it owns the connection service subscription)
+	// Note: Must be called BEFORE app_message_open() and before the window is pushed
+	pebble_messenger_init(glucose_data_received_callback, settings_received_callback, bluetooth_handler);
+	bluetooth_connected = pebble_messenger_is_connected();
 
 	window = window_create();
 	window_set_background_color(window, GColorBlack);
@@ -1282,37 +1977,52 @@ static void handle_init() {
 	// Open app message channel - larger buffers for glucose data
 	// Note: Only call once, messenger_init registers callbacks but doesn't open
 	const int inbound_size = 256;
-	const int outbound_size = 128;
+	const int outbound_size = 256;  // Room for the power ledger
 	app_message_open(inbound_size, outbound_size);
 
 	const bool animated = true;
 	window_stack_push(window, animated);
-  
-  // Sample as little as often to save battery and no need for precision
-  accel_service_set_sampling_rate(ACCEL_SAMPLING_10HZ);
-  accel_tap_service_subscribe(tap_handler);
+
+	// Subscribes to taps unless the profile (battery, quiet hours) says otherwise
+	update_power_profile();
 
 	// Subscribe to minute ticks
 	tick_timer_service_subscribe(MINUTE_UNIT, handle_minute_tick);
 
 #if DEBUG
 	// Button functionality
-	window_set_click_config_provider(window, (ClickConfigProvider) click_config_provider);
+	window_set_click_config_provider(window, click_config_provider);
 #endif
 }
 
 static void handle_deinit()
 {
+	// Settings and readings still queued must reach flash
+	work_queue_flush();
+	power_ledger_deinit();
+
 	tick_timer_service_unsubscribe();
-	accel_tap_service_unsubscribe();
-	connection_service_unsubscribe();
+	if (taps_subscribed) {
+		accel_tap_service_unsubscribe();
+	}
 	battery_state_service_unsubscribe();
 	pebble_messenger_deinit();
-	
-	// Clear animation pointers (animations auto-destroy when finished)
-	for (int i = 0; i < NUM_LINES; i++) {
-		lines[i].animation1 = NULL;
-		lines[i].animation2 = NULL;
+
+	if (date_timeout_timer) {
+		app_timer_cancel(date_timeout_timer);
+		date_timeout_timer = NULL;
+	}
+	if (tap_coalesce_timer) {
+		app_timer_cancel(tap_coalesce_timer);
+		tap_coalesce_timer = NULL;
+	}
+	if (phrase_precompute_timer) {
+		app_timer_cancel(phrase_precompute_timer);
+		phrase_precompute_timer = NULL;
+	}
+	if (phrase_flip_timer) {
+		app_timer_cancel(phrase_flip_timer);
+		phrase_flip_timer = NULL;
 	}
 	
 	// Free window
@@ -0,0 +1,91 @@
+#include "WorkQueue.h"
+#include "Log.h"
+
+#define WORK_QUEUE_SIZE 8
+
+typedef struct {
+  WorkQueueJob job;
+  void *context;
+} WorkItem;
+
+static WorkItem s_items[WORK_QUEUE_SIZE];
+static uint8_t s_count = 0;
+static bool s_held = false;
+static AppTimer *s_timer = NULL;
+
+static const uint32_t WORK_QUEUE_DELAY_MS = 50;       // Lets a burst of events finish first
+static const uint32_t WORK_QUEUE_MAX_HOLD_MS = 3000;  // Never wait longer than this for a transition
+
+static void schedule_run(void);
+
+// Run the jobs queued so far; jobs deferred while running wait for the next round
+static void run_jobs(void) {
+  WorkItem items[WORK_QUEUE_SIZE];
+  const uint8_t count = s_count;
+  memcpy(items, s_items, count * sizeof(WorkItem));
+  s_count = 0;
+
+  for (uint8_t i = 0; i < count; i++) {
+    items[i].job(items[i].context);
+  }
+}
+
+static void timer_callback(void *context) {
+  s_timer = NULL;
+  if (s_held) {
+    LOG_WARNING("Work queue held too long, running %d jobs", (int)s_count);
+  }
+  run_jobs();
+  schedule_run();
+}
+
+static void schedule_run(void) {
+  if (s_timer) {
+    app_timer_cancel(s_timer);
+    s_timer = NULL;
+  }
+  if (s_count > 0) {
+    s_timer = app_timer_register(s_held ? WORK_QUEUE_MAX_HOLD_MS : WORK_QUEUE_DELAY_MS, timer_callback, NULL);
+  }
+}
+
+void work_queue_defer(WorkQueueJob job, void *context) {
+  if (!job) return;
+
+  for (uint8_t i = 0; i < s_count; i++) {
+    if (s_items[i].job == job && s_items[i].context == context) {
+      return;
+    }
+  }
+
+  if (s_count == WORK_QUEUE_SIZE) {
+    LOG_WARNING("Work queue full, running job now");
+    job(context);
+    return;
+  }
+
+  s_items[s_count].job = job;
+  s_items[s_count].context = context;
+  s_count++;
+
+  if (!s_timer) {
+    schedule_run();
+  }
+}
+
+void work_queue_hold(bool held) {
+  if (held == s_held) return;
+  s_held = held;
+  schedule_run();
+}
+
+void work_queue_flush(void) {
+  if (s_timer) {
+    app_timer_cancel(s_timer);
+    s_timer = NULL;
+  }
+  // Only the jobs queued now: one that re-defers itself must not keep us here
+  run_jobs();
+  s_held = false;
+  schedule_run();
+}
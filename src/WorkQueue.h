@@ -0,0 +1,21 @@
+#pragma once
+
+#include <pebble.h>
+
+// Deferred work queue for jobs that need not run inside the event that
+// triggered them (persistence, outbound requests, redraws of async data).
+// Jobs run in FIFO order shortly after the current event burst, and not
+// before a running transition ends. Deferring a job that is already queued
+// with the same context merges the two into one run.
+
+typedef void (*WorkQueueJob)(void *context);
+
+// Queue a job; runs it immediately if the queue is full
+void work_queue_defer(WorkQueueJob job, void *context);
+
+// Hold queued jobs while a transition runs; releasing lets them run at once
+void work_queue_hold(bool held);
+
+// Run the jobs queued so far now (call before exiting); jobs they defer
+// wait for the next round
+void work_queue_flush(void);
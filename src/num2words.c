@@ -10,42 +10,14 @@
 
 #include "string.h"
 
-size_t min(const size_t a, const size_t b) {
-  return a < b ? a : b;
-}
-
-static size_t append_string(char* buffer, const size_t length, const char* str) {
-  strncat(buffer, str, length);
-
-  size_t written = strlen(str);
-  return (length > written) ? written : length;
-}
-
-static size_t interpolate_and_append(char* buffer, const size_t length,
-    const char* parent_str, const char* first_placeholder_str, const char* second_placeholder_str) {
-  const char* placeholder_str;
-  char* insert_ptr = strstr(parent_str, "$1");
-
-  if (insert_ptr) {
-    placeholder_str = first_placeholder_str;
-  }
-  else {
-    insert_ptr = strstr(parent_str, "$2");
-    placeholder_str = second_placeholder_str;
+// Copy up to length characters of str and return the new end of the text.
+// Stops at end, which callers leave one byte short of the buffer for the NUL.
+char* append_chars(char* cursor, const char* end, const char* str, size_t length) {
+  while (length > 0 && *str && cursor < end) {
+    *cursor++ = *str++;
+    length--;
   }
-
-  size_t parent_len = strlen(parent_str);
-  size_t insert_offset = insert_ptr ? (size_t) insert_ptr - (size_t) parent_str : parent_len;
-
-  size_t remaining = length;
-
-  remaining -= append_string(buffer, min(insert_offset, remaining), parent_str);
-  remaining -= append_string(buffer, remaining, placeholder_str);
-  if (insert_ptr) {
-    remaining -= append_string(buffer, remaining, insert_ptr + 2);
-  }
-
-  return remaining;
+  return cursor;
 }
 
 /* simple base 10 only itoa, found: http://stackoverflow.com/questions/20435527 */
@@ -131,34 +103,107 @@ const char* get_rel(Language lang, int index) {
   }
 }
 
-void time_to_words(Language lang, int hours, int minutes, int seconds, char* words, size_t buffer_size) {
+// Split a RELS_* string into word tokens and mark which words may share a line
+static void compile_template(PhraseTemplate* phrase, const char* source) {
+  const char* p = source;
+
+  phrase->source = source;
+  phrase->count = 0;
+
+  while (phrase->count < PHRASE_MAX_TOKENS) {
+    while (*p == ' ') {
+      p++;
+    }
+    if (*p == '\0') {
+      break;
+    }
+
+    PhraseToken* token = &phrase->tokens[phrase->count++];
+    token->flags = 0;
+
+    // A "*" before a word makes that word bold
+    if (*p == '*' && p[1] != '\0' && p[1] != ' ') {
+      token->flags |= PHRASE_TOKEN_BOLD;
+      p++;
+    }
+
+    const char* word = p;
+    while (*p != '\0' && *p != ' ') {
+      p++;
+    }
+    token->offset = (uint8_t) (word - source);
+    token->length = (uint8_t) (p - word);
+
+    if (token->length == 2 && word[0] == '$' && word[1] == '1') {
+      token->type = TOKEN_HOUR;
+    }
+    else if (token->length == 2 && word[0] == '$' && word[1] == '2') {
+      token->type = TOKEN_NEXT_HOUR;
+    }
+    else {
+      token->type = TOKEN_WORD;
+    }
+  }
+
+  // Neighbouring normal words may share a line; bold words stand alone
+  for (int i = 0; i + 1 < phrase->count; i++) {
+    if (!(phrase->tokens[i].flags & PHRASE_TOKEN_BOLD)
+        && !(phrase->tokens[i + 1].flags & PHRASE_TOKEN_BOLD)) {
+      phrase->tokens[i].flags |= PHRASE_TOKEN_GLUE;
+    }
+  }
+}
+
+static PhraseTemplate compiled_templates[PHRASE_TEMPLATES];
+static int compiled_lang = -1;
+
+// Templates of the given language, compiled on first use after a language change
+const PhraseTemplate* phrase_templates(Language lang) {
+  if (compiled_lang != (int) lang) {
+    for (int i = 0; i < PHRASE_TEMPLATES; i++) {
+      compile_template(&compiled_templates[i], get_rel(lang, i));
+    }
+    compiled_lang = lang;
+  }
+  return compiled_templates;
+}
 
-  size_t remaining = buffer_size;
-  memset(words, 0, buffer_size);
+const PhraseTemplate* time_to_template(Language lang, int hours, int minutes, int seconds, int* hour_index) {
 
   // We want to operate with a resolution of 30 seconds.  So multiply
   // minutes and seconds by 2.  Then divide by (2 * 5) to carve the hour
   // into five minute intervals.
   int half_mins  = (2 * minutes) + (seconds / 30);
   int rel_index  = ((half_mins + 5) / (2 * 5)) % 12;
-  int hour_index;
 
   if (rel_index == 0 && minutes > 30) {
-    hour_index = (hours + 1) % 24;
+    *hour_index = (hours + 1) % 24;
   }
   else {
-    hour_index = hours % 24;
+    *hour_index = hours % 24;
   }
 
-  const char* hour = get_hour(lang, hour_index);
-  const char* next_hour = get_hour(lang, (hour_index + 1) % 24);
-  const char* rel  = get_rel(lang, rel_index);
-
-  remaining -= interpolate_and_append(words, remaining, rel, hour, next_hour);
+  return &phrase_templates(lang)[rel_index];
+}
 
-  // Leave one space at the end
-  remaining -= append_string(words, remaining, " ");
+const char* phrase_token_text(Language lang, const PhraseTemplate* phrase, const PhraseToken* token,
+    int hour_index, size_t* length) {
+  const char* text;
 
+  switch (token->type) {
+    case TOKEN_HOUR:
+      text = get_hour(lang, hour_index);
+      *length = strlen(text);
+      break;
+    case TOKEN_NEXT_HOUR:
+      text = get_hour(lang, (hour_index + 1) % 24);
+      *length = strlen(text);
+      break;
+    default:
+      text = phrase->source + token->offset;
+      *length = token->length;
+  }
+  return text;
 }
 
 const char* get_day(Language lang, int index) {
@@ -180,21 +225,3 @@ const char* get_month(Language lang, int index) {
       return MONTHS_EN_US[index];
   }
 }
-
-void date_to_words(Language lang, int day, int date, int month, char* words, size_t buffer_size) {
-  size_t remaining = buffer_size;
-  memset(words, 0, buffer_size);
-  
-  const char* stringday = get_day(lang, day);
-  const char* stringmonth = get_month(lang, month);
-  
-  char stringdate[15];
-  itoa10(date, stringdate);
-  
-  remaining -= append_string(words, remaining, stringday);
-  remaining -= append_string(words, remaining, "  ");
-  remaining -= append_string(words, remaining, stringmonth);
-  remaining -= append_string(words, remaining, " ");
-  remaining -= append_string(words, remaining, stringdate);
-  remaining -= append_string(words, remaining, " ");
-}
\ No newline at end of file
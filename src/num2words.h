@@ -1,5 +1,6 @@
 #pragma once
 #include "string.h"
+#include <stdint.h>
 
 typedef enum {
   CA    = 0x0,
@@ -12,7 +13,41 @@ typedef enum {
   SV    = 0x7
 } Language;
 
-void time_to_words(Language lang, int hours, int minutes, int seconds, char* words, size_t length);
-void date_to_words(Language lang, int day, int date, int month, char* words, size_t length);
+#define PHRASE_TEMPLATES 12
+#define PHRASE_MAX_TOKENS 8
+
+// Flags of a phrase token
+#define PHRASE_TOKEN_BOLD 0x1  // word is printed bold
+#define PHRASE_TOKEN_GLUE 0x2  // word may share a line with the one after it
+
+typedef enum {
+  TOKEN_WORD      = 0x0,  // literal word of the template
+  TOKEN_HOUR      = 0x1,  // "$1", the current hour
+  TOKEN_NEXT_HOUR = 0x2   // "$2", the next hour
+} PhraseTokenType;
+
+typedef struct {
+  uint8_t offset;  // start of a literal word within the template string
+  uint8_t length;  // byte length of a literal word
+  uint8_t type;
+  uint8_t flags;
+} PhraseToken;
+
+// A RELS_* string split into words once per language
+typedef struct {
+  const char* source;
+  PhraseToken tokens[PHRASE_MAX_TOKENS];
+  uint8_t count;
+} PhraseTemplate;
+
+const char* get_hour(Language lang, int index);
+const char* get_day(Language lang, int index);
+const char* get_month(Language lang, int index);
+
+const PhraseTemplate* phrase_templates(Language lang);
+const PhraseTemplate* time_to_template(Language lang, int hours, int minutes, int seconds, int* hour_index);
+const char* phrase_token_text(Language lang, const PhraseTemplate* phrase, const PhraseToken* token,
+    int hour_index, size_t* length);
+char* append_chars(char* cursor, const char* end, const char* str, size_t length);
 
 char * itoa10(int value, char *result);
\ No newline at end of file
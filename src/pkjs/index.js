@@ -1,7 +1,5 @@
 var VERSION = "1.3.0";
-var Clay = require('pebble-clay');
-var clayConfig = require('./config.json');
-var clay = new Clay(clayConfig, null, { autoHandleEvents: false });
+var loadedAt = Date.now();
 const API = {
   BASE_URL: "https://api-eu.libreview.io",
   PRODUCT: "llu.android",
@@ -10,18 +8,107 @@ const API = {
 var testCredentials = {};
 
 var isReady = false;
+var readyAt = 0;
+var firstGlucoseSent = false;
 var callbacks = [];
 
+// Clay and config.json are only needed when the config page opens or closes.
+// Loading them on first use keeps them off the path to the first glucose send;
+// everything else reads our own stored options (getOptions).
+var clay = null;
+
+function getClay() {
+  if (!clay) {
+    var Clay = require('pebble-clay');
+    clay = new Clay(require('./config.json'), null, { autoHandleEvents: false });
+  }
+  return clay;
+}
+
 // Hardcoded default settings used when Clay has no stored values
 var DEFAULT_SETTINGS = {
   invert: 0,        // 0 = normal, 1 = inverted
   textAlign: 1,     // 1 = left
-  language: 3       // 3 = EN_US (see package.json messageKeys)
+  language: 3,      // 3 = EN_US (see package.json messageKeys)
+  estimate: 0,      // 0 = show readings only, 1 = project along the trend
+  power: 0          // 0 = automatic, 1 = full, 2 = saver, 3 = night
 };
 
 // Message keys generated by Pebble SDK (see package.json messageKeys)
 var KEYS = require('message_keys');
 
+// Leveled logging: messages above LOG_LEVEL are dropped before they reach the
+// log channel. Release builds keep warnings and errors; raise the level to
+// LOG_LEVELS.debug while developing. A function argument is only called
+// (and its message built) when the level is enabled.
+var LOG_LEVELS = { none: 0, error: 1, warn: 2, info: 3, debug: 4 };
+var LOG_LEVEL = LOG_LEVELS.warn;
+
+function makeLogger(level) {
+  return function(message) {
+    if (level > LOG_LEVEL) {
+      return;
+    }
+    console.log(typeof message === 'function' ? message() : message);
+  };
+}
+
+var log = {
+  error: makeLogger(LOG_LEVELS.error),
+  warn: makeLogger(LOG_LEVELS.warn),
+  info: makeLogger(LOG_LEVELS.info),
+  debug: makeLogger(LOG_LEVELS.debug)
+};
+
+// Trace capture: with TRACE_CAPTURE set, every message in and out with its
+// ack/nack, every XHR, fetch result and timer fire is recorded with its time
+// since load into a bounded buffer. Opening the settings page prints it as
+// one "TRACE {...}" log line; tools/replay-trace.js plays it back.
+var TRACE_CAPTURE = false;
+var TRACE_MAX_EVENTS = 500;
+var traceEvents = [];
+var traceSendId = 0;
+
+function trace(type, detail) {
+  if (!TRACE_CAPTURE) {
+    return;
+  }
+  var event = { t: Date.now() - loadedAt, type: type };
+  for (var key in detail) {
+    if (detail.hasOwnProperty(key)) {
+      event[key] = detail[key];
+    }
+  }
+  traceEvents.push(event);
+  if (traceEvents.length > TRACE_MAX_EVENTS) {
+    traceEvents.shift();
+  }
+}
+
+// The glucose source goes along: the replay answers in its format
+function exportTrace() {
+  return JSON.stringify({ version: VERSION, source: getCredentials().source, events: traceEvents });
+}
+
+Pebble.exportTrace = exportTrace;
+
+// All sends go through here so their outcome lands in the trace
+function sendMessage(message, onAck, onNack) {
+  var id = ++traceSendId;
+  trace('send', { id: id, payload: message });
+  Pebble.sendAppMessage(message, function(event) {
+    trace('ack', { id: id });
+    if (onAck) {
+      onAck(event);
+    }
+  }, function(event) {
+    trace('nack', { id: id, error: event && event.error });
+    if (onNack) {
+      onNack(event);
+    }
+  });
+}
+
 function onReady(callback) {
   if (isReady) {
     callback();
@@ -31,93 +118,249 @@ function onReady(callback) {
 }
 
 function logError(err) {
-  console.log('AppMessage error: ' + JSON.stringify(err));
+  log.error('AppMessage error: ' + JSON.stringify(err));
 }
 
 // Store latest glucose data
 var glucoseData = {
   value: 0,
   trend: -1,
-  timestamp: 0
+  timestamp: 0,
+  patients: []      // every followed patient, [0] is the reading above
 };
 
-// Cache configuration
-var CACHE_KEY = 'glucose_cache';
-var CACHE_MAX_AGE_MS = 5 * 60 * 1000; // 10 minutes - glucose updates every 15 min
+// Readings sent per message when the account follows several patients
+// (must match MAX_PATIENTS in AppRequests.h)
+var MAX_PATIENTS = 4;
+
+// Timestamps of the readings the watch is known to hold, one per patient in
+// the order sent (from its requests and our delivered sends); a send that
+// brings no patient a newer reading is skipped
+var watchTimestamps = [];
+var sendingTimestamps = null;  // those of a send awaiting its ack
+
+// Reading store: the recent readings of every followed patient, oldest first,
+// kept as flat [timestamp, value, trend, ...] triples keyed by sensor time.
+// Graph history lands here too, so conditional requests from the watch are
+// answered from it instead of another download.
+var STORE_KEY = 'reading_store';
+var LEGACY_CACHE_KEY = 'glucose_cache';
+var STORE_MAX_READINGS = 144;             // per patient, 12 hours of 5 minute readings
+var STORE_FLUSH_DELAY_MS = 5 * 1000;      // updates within this window share one write
+var CACHE_MAX_AGE_MS = 5 * 60 * 1000;     // refetch after this, readings come every 1-5 min
+
+var readingStore = null;
+var storeFlushTimer = null;
+var pendingFetch = null;  // the fetch under way, shared by callers meanwhile
+
+function emptyReadingStore() {
+  return { fetchedAt: 0, patients: [] };
+}
 
-// Glucose cache functions
-function getCachedGlucose() {
+function loadReadingStore() {
+  if (readingStore) {
+    return readingStore;
+  }
   try {
-    var cached = localStorage.getItem(CACHE_KEY);
-    if (!cached) {
-      console.log('No cached glucose data found');
-      return null;
-    }
-    
-    var data = JSON.parse(cached);
-    var age = Date.now() - data.cachedAt;
-    
-    if (age > CACHE_MAX_AGE_MS) {
-      console.log('Cached glucose data expired (age: ' + Math.round(age / 1000) + 's)');
-      return null;
-    }
-    
-    console.log('Using cached glucose data (age: ' + Math.round(age / 1000) + 's)');
-    return data;
+    localStorage.removeItem(LEGACY_CACHE_KEY);
+    readingStore = JSON.parse(localStorage.getItem(STORE_KEY) || 'null');
   } catch (e) {
-    console.log('Error reading glucose cache: ' + e.message);
-    return null;
+    log.error('Error reading reading store: ' + e.message);
   }
+  if (!readingStore || !readingStore.patients) {
+    readingStore = emptyReadingStore();
+  }
+  return readingStore;
 }
 
-function setCachedGlucose(value, trend, timestamp) {
+function flushReadingStore() {
+  if (storeFlushTimer) {
+    clearTimeout(storeFlushTimer);
+    storeFlushTimer = null;
+  }
   try {
-    var data = {
-      value: value,
-      trend: trend,
-      timestamp: timestamp,
-      cachedAt: Date.now()
-    };
-    localStorage.setItem(CACHE_KEY, JSON.stringify(data));
-    console.log('Glucose data cached');
+    localStorage.setItem(STORE_KEY, JSON.stringify(loadReadingStore()));
+    log.debug('Reading store written');
   } catch (e) {
-    console.log('Error caching glucose data: ' + e.message);
+    log.error('Error writing reading store: ' + e.message);
   }
 }
 
-function clearGlucoseCache() {
-  try {
-    localStorage.removeItem(CACHE_KEY);
-    console.log('Glucose cache cleared');
-  } catch (e) {
-    console.log('Error clearing glucose cache: ' + e.message);
+function scheduleStoreFlush() {
+  if (!storeFlushTimer) {
+    storeFlushTimer = setTimeout(function() {
+      trace('timer', { name: 'storeFlush' });
+      flushReadingStore();
+    }, STORE_FLUSH_DELAY_MS);
+  }
+}
+
+// Insert readings ({ value, trend, ts }) into a series in timestamp order;
+// timestamps already stored are skipped. Returns how many were new.
+function insertReadings(series, readings) {
+  var added = 0;
+  readings.forEach(function(reading) {
+    var i = series.length;
+    while (i > 0 && series[i - 3] > reading.ts) {
+      i -= 3;
+    }
+    if (i > 0 && series[i - 3] === reading.ts) {
+      return;
+    }
+    series.splice(i, 0, reading.ts, reading.value, reading.trend);
+    added++;
+  });
+  if (series.length > STORE_MAX_READINGS * 3) {
+    series.splice(0, series.length - STORE_MAX_READINGS * 3);
+  }
+  return added;
+}
+
+// Record the patients of a fetch (in the order the watch shows them) with
+// their graph history. Returns how many readings were new.
+function storeFetch(patients) {
+  var store = loadReadingStore();
+  var added = 0;
+  store.patients = patients.map(function(patient) {
+    var entry = store.patients.filter(function(stored) { return stored.id === patient.id; })[0] ||
+                { id: patient.id, readings: [] };
+    entry.initials = patient.initials;
+    // The measurement first: its trend beats a graph point of the same time
+    added += insertReadings(entry.readings, (patient.ts ? [patient] : []).concat(patient.history || []));
+    return entry;
+  });
+  store.fetchedAt = Date.now();
+  scheduleStoreFlush();
+  return added;
+}
+
+// Newest stored reading of every patient in the shape fetches resolve with,
+// or null when nothing is stored
+function latestFromStore() {
+  var patients = [];
+  loadReadingStore().patients.forEach(function(entry) {
+    var series = entry.readings;
+    if (series.length >= 3) {
+      var n = series.length;
+      patients.push({ id: entry.id, initials: entry.initials,
+                      ts: series[n - 3], value: series[n - 2], trend: series[n - 1] });
+    }
+  });
+  if (!patients.length) {
+    return null;
+  }
+  return { value: patients[0].value, trend: patients[0].trend, ts: patients[0].ts, patients: patients };
+}
+
+function clearReadingStore() {
+  // Freshness histograms describe the pipeline, not the account: keep them
+  var freshness = loadReadingStore().freshness;
+  readingStore = emptyReadingStore();
+  readingStore.freshness = freshness;
+  flushReadingStore();
+  log.debug('Reading store cleared');
+}
+
+// Data freshness: how long each stage takes a reading from the sensor to the
+// wrist, as histograms kept with the reading store. Buckets are counts of
+// durations up to each bound (ms), the last one counts everything longer.
+var FRESHNESS_BOUNDS_MS = [100, 300, 1000, 3000, 10000, 30000, 60000, 120000, 300000, 600000, 900000];
+var FRESHNESS_STAGES = ['sensorToFetch', 'fetchToSend', 'sendToAck', 'receiveToDisplay', 'sensorToDisplay'];
+
+// The newest fetched reading on its way to the watch
+var freshnessTs = 0;         // its sensor time (s)
+var freshnessFetchedAt = 0;  // when the fetch completed, 0 once it was sent
+
+function recordFreshness(stage, ms) {
+  var store = loadReadingStore();
+  if (!store.freshness) {
+    store.freshness = {};
   }
+  if (!store.freshness[stage]) {
+    store.freshness[stage] = FRESHNESS_BOUNDS_MS.map(function() { return 0; }).concat([0]);
+  }
+  var bucket = 0;
+  while (bucket < FRESHNESS_BOUNDS_MS.length && ms > FRESHNESS_BOUNDS_MS[bucket]) {
+    bucket++;
+  }
+  store.freshness[stage][bucket]++;
+  scheduleStoreFlush();
+  log.debug(function() { return 'Freshness ' + stage + ': ' + Math.round(ms) + ' ms'; });
+}
+
+// Histograms per stage as { stage: [{ upToMs, count }...] }
+function freshnessReport() {
+  var freshness = loadReadingStore().freshness || {};
+  var report = {};
+  FRESHNESS_STAGES.forEach(function(stage) {
+    report[stage] = (freshness[stage] || []).map(function(count, bucket) {
+      return { upToMs: FRESHNESS_BOUNDS_MS[bucket] || null, count: count };
+    });
+  });
+  return report;
 }
 
-// Main function to get glucose data - uses cache when available
-// forceRefresh: if true, bypasses cache and fetches fresh data from API
-// credentials: optional {email, password} - if provided, uses these instead of getCredentials()
+Pebble.freshnessReport = freshnessReport;
+
+// Main function to get glucose data - uses the reading store when it is recent
+// forceRefresh: if true, bypasses the store and fetches fresh data from API
+// credentials: optional, as from getCredentials() - if provided, used instead of the stored ones
 function getGlucoseData(forceRefresh, credentials) {
-  // Check cache first (unless force refresh)
-  if (!forceRefresh) {
-    var cached = getCachedGlucose();
-    if (cached) {
-      console.log('Returning cached glucose: ' + cached.value + ' mg/dL');
-      return Promise.resolve({ value: cached.value, trend: cached.trend, ts: cached.timestamp });
+  // Check the store first (unless force refresh)
+  var age = Date.now() - loadReadingStore().fetchedAt;
+  if (!forceRefresh && age <= CACHE_MAX_AGE_MS) {
+    var stored = latestFromStore();
+    if (stored) {
+      log.debug('Returning stored glucose: ' + stored.value + ' mg/dL (fetched ' + Math.round(age / 1000) + 's ago)');
+      return Promise.resolve(stored);
     }
   }
   
+  // Startup and the watch's first request both get here before either fetch
+  // completes; they share one (and one login). New credentials fetch anew.
+  if (pendingFetch && !credentials) {
+    return pendingFetch;
+  }
+
   // Get credentials - use provided ones or fetch from storage
-  var creds;
-  if (credentials && credentials.email && credentials.password) {
-    creds = credentials;
-    console.log('getGlucoseData: using provided credentials');
-  } else {
-    creds = getCredentials();
+  var creds = credentials || getCredentials();
+
+  // Ask only for what is newer than the store's latest reading; the source
+  // decides whether its backend can filter
+  var source = glucoseSource(creds);
+  var latest = latestFromStore();
+  var fetch = latest ? source.fetchSince(creds, latest.ts) : source.fetchLatest(creds);
+
+  // Keep fresh data with what we have and answer from the store
+  var request = fetch.then(function(data) {
+    trace('fetch', { patients: data && data.patients.filter(function(patient) {
+      return patient.ts;
+    }).map(function(patient) {
+      return { value: patient.value, trend: patient.trend, ts: patient.ts, initials: patient.initials };
+    }) });
+    if (!data) {
+      return null;
+    }
+    var added = storeFetch(data.patients);
+    if (added === 0) {
+      log.info('Fetch returned nothing new');
+    }
+    var stored = latestFromStore();
+    if (added && stored && stored.ts > freshnessTs) {
+      freshnessTs = stored.ts;
+      freshnessFetchedAt = Date.now();
+      recordFreshness('sensorToFetch', freshnessFetchedAt - stored.ts * 1000);
+    }
+    return stored;
+  });
+  function settled() {
+    if (pendingFetch === request) {
+      pendingFetch = null;
+    }
   }
-  
-  // Fetch fresh data from API
-  return fetchGlucoseFromLibreLinkUp(creds.email, creds.password);
+  pendingFetch = request;
+  request.then(settled, settled);
+  return request;
 }
 
 // SHA256 für Account-Id (pure JS implementation)
@@ -204,8 +447,10 @@ function sha256Hex(str) {
 }
 
 function readyCallback(event) {
+  trace('ready', {});
   isReady = true;
-  console.log("Pebble JS ready");
+  readyAt = Date.now();
+  log.info('Pebble JS ready ' + (readyAt - loadedAt) + ' ms after load');
   while (callbacks.length > 0) {
     var callback = callbacks.shift();
     callback(event);
@@ -213,58 +458,95 @@ function readyCallback(event) {
 }
 
 function showConfiguration(event) {
-  console.log('Configuration page requested (Clay)');
-  Pebble.openURL(clay.generateUrl());
+  log.info('Configuration page requested (Clay)');
+  if (TRACE_CAPTURE) {
+    console.log('TRACE ' + exportTrace());
+  }
+  Pebble.openURL(getClay().generateUrl());
 }
 
 function webviewclosed(event) {
   if (!event || !event.response || event.response === 'CANCELLED') {
-    console.log('Configuration cancelled or empty');
+    log.info('Configuration cancelled or empty');
     return;
   }
 
   try {
     // Use convert=false to get raw settings with readable keys
-    var rawSettings = clay.getSettings(event.response, false);
-    console.log('Clay raw settings: ' + JSON.stringify(rawSettings));
-    console.log('Clay email type: ' + typeof rawSettings.email + ', value: ' + JSON.stringify(rawSettings.email));
-    console.log('Clay password type: ' + typeof rawSettings.password + ', value: ' + (rawSettings.password ? '***' : 'undefined'));
+    var rawSettings = getClay().getSettings(event.response, false);
+    log.debug(function() { return 'Clay raw settings: ' + JSON.stringify(rawSettings); });
+    log.debug(function() { return 'Clay email type: ' + typeof rawSettings.email + ', value: ' + JSON.stringify(rawSettings.email); });
+    log.debug('Clay password type: ' + typeof rawSettings.password + ', value: ' + (rawSettings.password ? '***' : 'undefined'));
 
     localStorage.setItem('options', JSON.stringify(rawSettings));
-    console.log('Stored options to localStorage');
-
-    // Extract credentials directly from rawSettings (handle both direct and wrapped values)
-    var email = rawSettings.email;
-    if (email && typeof email === 'object') {
-      email = email.value;
-    }
-    var password = rawSettings.password;
-    if (password && typeof password === 'object') {
-      password = password.value;
-    }
-    console.log('Extracted credentials - email: ' + (email ? email.substring(0, 3) + '***' : 'undefined'));
+    log.info('Stored options to localStorage');
 
-    // Clear cache when settings change (credentials may have changed)
-    clearGlucoseCache();
+    // Clear the store when settings change (credentials may have changed); a
+    // new account's reading must replace the watch's even if it is older
+    clearReadingStore();
+    watchTimestamps = [];
+    sendingTimestamps = null;
 
     // Build message using the normalized helper so defaults are applied when missing
     var message = prepareConfiguration(rawSettings);
-    console.log('Sending message to watch: ' + JSON.stringify(message));
+    log.debug(function() { return 'Sending message to watch: ' + JSON.stringify(message); });
     sendSettingsToWatch(message);
 
-    // Fetch fresh glucose data with new settings (pass credentials directly)
-    getGlucoseData(true, { email: email, password: password }).then(function(data) {
+    // Fetch fresh glucose data with the new source and credentials
+    getGlucoseData(true, getCredentials()).then(function(data) {
       if (data) {
-        updateGlucoseData(data.value, data.trend, data.ts);
+        updateGlucoseData(data.value, data.trend, data.ts, data.patients);
       } else {
-        console.log('No glucose data fetched after settings save');
+        log.warn('No glucose data fetched after settings save');
       }
     }).catch(function(err) {
-      console.log('Error fetching glucose after settings save: ' + err.message);
+      log.warn('Error fetching glucose after settings save: ' + err.message);
     });
   } catch (e) {
-    console.log('Error parsing configuration: ' + e.message + ' - ' + e.stack);
+    log.error('Error parsing configuration: ' + e.message + ' - ' + e.stack);
+  }
+}
+
+// Hash of the last settings the watch acknowledged (see settingsHash)
+var SETTINGS_HASH_KEY = 'settings_hash';
+// Hash of the settings sent this session, while in flight or once acked;
+// requests the watch made before they arrived still report the old hash
+var settingsSentHash = null;
+
+// FNV-1a over the (key, value) byte pairs of a settings message in key order,
+// the same as settings_hash() in TextWatch.c
+function settingsHash(message) {
+  var hash = 2166136261;
+  function mix(value) {
+    hash ^= value & 0xff;
+    // hash * 16777619 in 32 bits
+    hash = (hash + (hash << 1) + (hash << 4) + (hash << 7) + (hash << 8) + (hash << 24)) >>> 0;
   }
+  Object.keys(message).map(Number).sort(function(a, b) { return a - b; }).forEach(function(key) {
+    mix(key);
+    mix(message[key]);
+  });
+  return hash;
+}
+
+function rememberSettingsHash(message) {
+  localStorage.setItem(SETTINGS_HASH_KEY, String(settingsHash(message)));
+}
+
+// Sends settings, remembering them for the duration of the send; a nack
+// lets the next mismatching request send them again
+function sendSettings(message, onAck, onNack) {
+  var hash = settingsHash(message);
+  settingsSentHash = hash;
+  sendMessage(message, function(event) {
+    rememberSettingsHash(message);
+    onAck(event);
+  }, function(event) {
+    if (settingsSentHash === hash) {
+      settingsSentHash = null;
+    }
+    onNack(event);
+  });
 }
 
 function sendSettingsToWatch(message) {
@@ -273,10 +555,10 @@ function sendSettingsToWatch(message) {
     return;
   }
 
-  Pebble.sendAppMessage(message, function() {
-    console.log('Settings delivered to watch: ' + JSON.stringify(message));
+  sendSettings(message, function() {
+    log.info(function() { return 'Settings delivered to watch: ' + JSON.stringify(message); });
   }, function(err) {
-    console.log('Error sending settings: ' + JSON.stringify(err));
+    log.error('Error sending settings: ' + JSON.stringify(err));
   });
 }
 
@@ -287,32 +569,32 @@ function getOptions() {
 function parseOptions() {
   try {
     var raw = getOptions();
-    console.log('parseOptions raw: ' + raw);
+    log.debug('parseOptions raw: ' + raw);
     var parsed = JSON.parse(raw);
-    console.log('parseOptions parsed keys: ' + Object.keys(parsed).join(', '));
+    log.debug('parseOptions parsed keys: ' + Object.keys(parsed).join(', '));
     return parsed;
   } catch (e) {
-    console.log('Error parsing stored options, using defaults: ' + e.message);
+    log.error('Error parsing stored options, using defaults: ' + e.message);
     return {};
   }
 }
 
+// Clay may store values directly or wrapped in {value: ...} objects
+function optionValue(options, name) {
+  var value = options[name];
+  if (value && typeof value === 'object') {
+    value = value.value;
+  }
+  return value;
+}
+
 // Unified credential retrieval - single source of truth
 function getCredentials() {
   var options = parseOptions();
+  var email = optionValue(options, 'email');
+  var password = optionValue(options, 'password');
   
-  // Clay may store values directly or wrapped in {value: ...} objects
-  var email = options.email;
-  if (email && typeof email === 'object') {
-    email = email.value;
-  }
-  
-  var password = options.password;
-  if (password && typeof password === 'object') {
-    password = password.value;
-  }
-  
-  console.log('getCredentials: email=' + (email ? email.substring(0, 3) + '***' : 'undefined') + ', password=' + (password ? '***' : 'undefined'));
+  log.debug('getCredentials: email=' + (email ? email.substring(0, 3) + '***' : 'undefined') + ', password=' + (password ? '***' : 'undefined'));
   
   // Fallback to test credentials if not configured
   if (!email && testCredentials.email) {
@@ -322,7 +604,13 @@ function getCredentials() {
     password = testCredentials.password;
   }
   
-  return { email: email, password: password };
+  return {
+    source: optionValue(options, 'source') || 'librelinkup',
+    email: email,
+    password: password,
+    nightscoutUrl: optionValue(options, 'nightscoutUrl'),
+    nightscoutToken: optionValue(options, 'nightscoutToken')
+  };
 }
 
 // Normalize Clay settings, applying defaults when no value was provided
@@ -345,10 +633,22 @@ function getSettingsWithDefaults(options) {
     language = language.value;
   }
 
+  var estimate = (typeof opts.ESTIMATE_KEY !== 'undefined') ? opts.ESTIMATE_KEY : opts.ESTIMATE;
+  if (estimate && typeof estimate === 'object') {
+    estimate = estimate.value;
+  }
+
+  var power = (typeof opts.POWER_KEY !== 'undefined') ? opts.POWER_KEY : opts.POWER;
+  if (power && typeof power === 'object') {
+    power = power.value;
+  }
+
   return {
     INVERT: (typeof invert !== 'undefined') ? invert : DEFAULT_SETTINGS.invert,
     TEXT_ALIGN: (typeof align !== 'undefined') ? parseInt(align, 10) : DEFAULT_SETTINGS.textAlign,
-    LANGUAGE: (typeof language !== 'undefined') ? parseInt(language, 10) : DEFAULT_SETTINGS.language
+    LANGUAGE: (typeof language !== 'undefined') ? parseInt(language, 10) : DEFAULT_SETTINGS.language,
+    ESTIMATE: (typeof estimate !== 'undefined') ? estimate : DEFAULT_SETTINGS.estimate,
+    POWER: (typeof power !== 'undefined') ? parseInt(power, 10) : DEFAULT_SETTINGS.power
   };
 }
 
@@ -360,39 +660,199 @@ function prepareConfiguration(optionsJson) {
   message[KEYS.INVERT_KEY] = settings.INVERT ? 1 : 0;
   message[KEYS.TEXT_ALIGN_KEY] = settings.TEXT_ALIGN;
   message[KEYS.LANGUAGE_KEY] = settings.LANGUAGE;
+  message[KEYS.ESTIMATE_KEY] = settings.ESTIMATE ? 1 : 0;
+  message[KEYS.POWER_KEY] = settings.POWER;
 
   return message;
 }
 
 function appmessage(event) {
-  console.log('Received message from watch');
+  log.debug('Received message from watch');
   var payload = event.payload;
+  trace('in', { payload: payload });
+
+  // The watch reports how old the last reading was when it was drawn
+  if (payload && typeof payload[KEYS.KEY_DISPLAY_AGE] !== 'undefined') {
+    recordFreshness('sensorToDisplay', payload[KEYS.KEY_DISPLAY_AGE] * 1000);
+    recordFreshness('receiveToDisplay', payload[KEYS.KEY_DISPLAY_DELAY] || 0);
+    log.info('Reading was ' + payload[KEYS.KEY_DISPLAY_AGE] + ' s old when the watch drew it');
+  }
+
+  if (payload && payload[KEYS.KEY_LEDGER_DATA]) {
+    storePowerLedger(decodePowerLedger(payload[KEYS.KEY_LEDGER_DATA]));
+  }
+
+  // Every request reports the hash of the settings stored on the watch
+  if (payload && typeof payload[KEYS.KEY_SETTINGS_HASH] !== 'undefined') {
+    var settings = prepareConfiguration(getOptions());
+    var hash = settingsHash(settings);
+    if ((payload[KEYS.KEY_SETTINGS_HASH] >>> 0) !== hash && settingsSentHash !== hash) {
+      log.info('Watch settings differ from ours, sending them');
+      transmitConfiguration(settings);
+    }
+  }
 
   if (payload && payload[KEYS.KEY_REQUEST_DATA]) {
-    console.log('Watch requested glucose data');
-    // Use cache when available (no force refresh - this is the main use case for caching)
+    // The watch sends the timestamps of the readings it already shows
+    watchTimestamps = readWatchTimestamps(payload);
+    log.info('Watch requested glucose data newer than ' + watchTimestamps.join(', '));
+    followWatchInterval(payload[KEYS.KEY_REQUEST_INTERVAL]);
+    // Answer from the reading store when it is recent (no force refresh)
     getGlucoseData(false).then(function(data) {
-      if (data) {
-        updateGlucoseData(data.value, data.trend, data.ts);
+      if (data && data.ts && !bringsNewReadings(patientTimestamps(data.ts, data.patients), watchTimestamps)) {
+        sendNotModified();
+      } else if (data) {
+        updateGlucoseData(data.value, data.trend, data.ts, data.patients);
       } else {
-        console.log('No glucose data fetched');
+        log.warn('No glucose data fetched');
       }
     }).catch(function(err) {
-      console.log('Error fetching glucose: ' + err.message);
+      log.warn('Error fetching glucose: ' + err.message);
+    });
+  }
+}
+
+// Power ledger: hourly activity counters kept by the watch (see PowerLedger.h)
+var LEDGER_KEY = 'power_ledger';
+var LEDGER_MAX_HOURS = 48;
+var LEDGER_COUNTER_NAMES = ['requests', 'inbound', 'inboundBytes', 'animations',
+  'redrawTop', 'redrawBottom', 'redrawArrow', 'taps', 'persistWrites'];
+var LEDGER_REQUEST_INTERVAL_MS = 60 * 60 * 1000;
+
+function requestPowerLedger() {
+  var message = {};
+  message[KEYS.KEY_LEDGER_REQUEST] = 1;
+  sendMessage(message, function() {
+    log.info('Power ledger requested');
+  }, logError);
+}
+
+function readLittleEndian(bytes, offset, length) {
+  var value = 0;
+  for (var i = length - 1; i >= 0; i--) {
+    value = value * 256 + bytes[offset + i];
+  }
+  return value;
+}
+
+// [counters, hours, { int32 hour, uint16 counts[counters] }...]
+function decodePowerLedger(bytes) {
+  var counters = bytes[0];
+  var hours = bytes[1];
+  var size = 4 + 2 * counters;
+  var result = [];
+  for (var i = 0; i < hours; i++) {
+    var offset = 2 + i * size;
+    var entry = { hour: readLittleEndian(bytes, offset, 4) };
+    for (var c = 0; c < counters; c++) {
+      entry[LEDGER_COUNTER_NAMES[c] || ('counter' + c)] = readLittleEndian(bytes, offset + 4 + 2 * c, 2);
+    }
+    result.push(entry);
+  }
+  return result;
+}
+
+// Keep the newest LEDGER_MAX_HOURS hours; later reports of an hour replace earlier ones
+function storePowerLedger(entries) {
+  try {
+    var stored = JSON.parse(localStorage.getItem(LEDGER_KEY) || '{}');
+    entries.forEach(function(entry) {
+      stored[entry.hour] = entry;
+      log.info(function() {
+        return 'Power ledger ' + new Date(entry.hour * 3600 * 1000).toISOString() + ': ' + JSON.stringify(entry);
+      });
+    });
+    var hours = Object.keys(stored).sort(function(a, b) { return a - b; });
+    hours.slice(0, Math.max(0, hours.length - LEDGER_MAX_HOURS)).forEach(function(hour) {
+      delete stored[hour];
     });
+    localStorage.setItem(LEDGER_KEY, JSON.stringify(stored));
+  } catch (e) {
+    log.error('Error storing power ledger: ' + e.message);
   }
 }
 
 function transmitConfiguration(settings) {
-  console.log('Sending configuration: ' + JSON.stringify(settings));
-  Pebble.sendAppMessage(settings, function(event) {
-    console.log('Configuration delivered successfully');
+  log.debug(function() { return 'Sending configuration: ' + JSON.stringify(settings); });
+  sendSettings(settings, function(event) {
+    log.info('Configuration delivered successfully');
+  }, logError);
+}
+
+function sendNotModified() {
+  var message = {};
+  message[KEYS.KEY_NOT_MODIFIED] = 1;
+
+  log.info('Watch is up to date, sending not modified');
+  sendMessage(message, function(event) {
+    log.debug('Not modified delivered');
   }, logError);
 }
 
+// Timestamp of each patient's reading as the watch would hold it after a send
+// (one patient goes without KEY_PATIENTS, only its KEY_TIMESTAMP)
+function patientTimestamps(timestamp, patients) {
+  if (!patients || patients.length <= 1) {
+    return [timestamp];
+  }
+  return patients.slice(0, MAX_PATIENTS).map(function(patient) { return patient.ts || 0; });
+}
+
+// What a request reports: a timestamp per patient (KEY_PATIENT_TIMESTAMPS)
+// when the watch holds several, else that of its one reading, if any
+function readWatchTimestamps(payload) {
+  var bytes = payload[KEYS.KEY_PATIENT_TIMESTAMPS];
+  if (bytes && bytes.length) {
+    var timestamps = [];
+    for (var offset = 0; offset + 4 <= bytes.length; offset += 4) {
+      timestamps.push(readLittleEndian(bytes, offset, 4));
+    }
+    return timestamps;
+  }
+  return payload[KEYS.KEY_TIMESTAMP] ? [payload[KEYS.KEY_TIMESTAMP]] : [];
+}
+
+// Whether any patient has a reading newer than the watch's copy of it; a
+// different patient list is always new
+function bringsNewReadings(timestamps, known) {
+  if (!known || known.length !== timestamps.length) {
+    return true;
+  }
+  return timestamps.some(function(ts, i) { return ts > known[i]; });
+}
+
+function writeLittleEndian(bytes, value, length) {
+  for (var i = 0; i < length; i++) {
+    bytes.push(value & 0xFF);
+    value = Math.floor(value / 256);
+  }
+}
+
+// [count, { int16 value, int8 trend, int32 timestamp, char initials[2] }...]
+// (see KEY_PATIENTS in AppRequests.h)
+function packPatients(patients) {
+  var bytes = [patients.length];
+  patients.forEach(function(patient) {
+    writeLittleEndian(bytes, patient.value, 2);
+    bytes.push(patient.trend & 0xFF);
+    writeLittleEndian(bytes, patient.ts >>> 0, 4);
+    for (var i = 0; i < 2; i++) {
+      var code = (patient.initials || '').charCodeAt(i);
+      bytes.push(code >= 32 && code < 127 ? code : 32);
+    }
+  });
+  return bytes;
+}
+
 function sendGlucoseData() {
   if (glucoseData.value <= 0) {
-    console.log('No glucose data to send');
+    log.debug('No glucose data to send');
+    return;
+  }
+  var timestamps = patientTimestamps(glucoseData.timestamp, glucoseData.patients);
+  if (!bringsNewReadings(timestamps, watchTimestamps) ||
+      (sendingTimestamps && !bringsNewReadings(timestamps, sendingTimestamps))) {
+    log.debug('Watch already has or is being sent the readings of ' + timestamps.join(', '));
     return;
   }
 
@@ -400,21 +860,48 @@ function sendGlucoseData() {
   message[KEYS.KEY_GLUCOSE_VALUE] = glucoseData.value;
   message[KEYS.KEY_TREND_VALUE] = glucoseData.trend;
   message[KEYS.KEY_TIMESTAMP] = glucoseData.timestamp;
+  // Followers of several patients get all of them at once; the watch rotates
+  // through them without asking again
+  if (glucoseData.patients.length > 1) {
+    message[KEYS.KEY_PATIENTS] = packPatients(glucoseData.patients.slice(0, MAX_PATIENTS));
+  }
 
-  console.log('Sending glucose data: ' + JSON.stringify(message));
-  Pebble.sendAppMessage(message, function(event) {
-    console.log('Glucose data delivered');
-  }, logError);
+  log.debug(function() { return 'Sending glucose data: ' + JSON.stringify(message); });
+  if (!firstGlucoseSent) {
+    firstGlucoseSent = true;
+    log.info('First glucose send ' + (Date.now() - readyAt) + ' ms after ready');
+  }
+  var sentAt = Date.now();
+  sendingTimestamps = timestamps;
+  function sendDone() {
+    if (sendingTimestamps === timestamps) {
+      sendingTimestamps = null;
+    }
+  }
+  var measureSend = glucoseData.timestamp === freshnessTs && freshnessFetchedAt > 0;
+  if (measureSend) {
+    recordFreshness('fetchToSend', sentAt - freshnessFetchedAt);
+    freshnessFetchedAt = 0;
+  }
+  sendMessage(message, function(event) {
+    if (measureSend) {
+      recordFreshness('sendToAck', Date.now() - sentAt);
+    }
+    sendDone();
+    watchTimestamps = timestamps;
+    log.info('Glucose data delivered');
+  }, function(event) {
+    sendDone();
+    logError(event);
+  });
 }
 
-function updateGlucoseData(value, trend, timestamp) {
+function updateGlucoseData(value, trend, timestamp, patients) {
   glucoseData.value = value || 0;
   glucoseData.trend = (typeof trend !== 'undefined') ? trend : -1;
   glucoseData.timestamp = timestamp || Math.floor(Date.now() / 1000);
-  console.log('Glucose updated: ' + glucoseData.value + ' mg/dL, trend: ' + glucoseData.trend);
-
-  // Cache the glucose data
-  setCachedGlucose(glucoseData.value, glucoseData.trend, glucoseData.timestamp);
+  glucoseData.patients = patients || [];
+  log.info('Glucose updated: ' + glucoseData.value + ' mg/dL, trend: ' + glucoseData.trend);
 
   onReady(function() {
     sendGlucoseData();
@@ -426,20 +913,20 @@ Pebble.updateGlucose = updateGlucoseData;
 // Hilfsfunktion: letzte Messung
 function pickMeasurement(container) {
   if (!container) {
-    console.log("pickMeasurement: container is null");
+    log.debug("pickMeasurement: container is null");
     return null;
   }
 
-  console.log("pickMeasurement: container keys = " + Object.keys(container).join(", "));
+  log.debug("pickMeasurement: container keys = " + Object.keys(container).join(", "));
 
   // Try to get measurement from various possible locations
   var m = container.glucoseMeasurement || container.glucoseItem;
   
   if (m) {
-    console.log("pickMeasurement: found glucoseMeasurement/glucoseItem");
+    log.debug("pickMeasurement: found glucoseMeasurement/glucoseItem");
     // Check if it has measurementData array
     if (m.measurementData && Array.isArray(m.measurementData) && m.measurementData.length > 0) {
-      console.log("pickMeasurement: using measurementData array, length=" + m.measurementData.length);
+      log.debug("pickMeasurement: using measurementData array, length=" + m.measurementData.length);
       return m.measurementData[m.measurementData.length - 1];
     }
     // Otherwise return the measurement object itself
@@ -448,22 +935,107 @@ function pickMeasurement(container) {
   
   // If no glucoseMeasurement/glucoseItem, the container might be the measurement itself
   if (container.ValueInMgPerDl || container.Value) {
-    console.log("pickMeasurement: container is the measurement itself");
+    log.debug("pickMeasurement: container is the measurement itself");
     return container;
   }
   
-  console.log("pickMeasurement: no measurement found in container");
+  log.debug("pickMeasurement: no measurement found in container");
   return null;
 }
+function toReading(measurement) {
+  if (!measurement || (!measurement.ValueInMgPerDl && !measurement.Value)) {
+    return null;
+  }
+
+  var value = measurement.ValueInMgPerDl || measurement.Value;
+  var trend = measurement.TrendArrow !== undefined ? measurement.TrendArrow : (measurement.Trend !== undefined ? measurement.Trend : -1);
+  var tsString = measurement.Timestamp || measurement.FactoryTimestamp;
+  var ts = tsString ? Math.floor(new Date(tsString).getTime() / 1000) : Math.floor(Date.now() / 1000);
+
+  return { value: value, trend: trend, ts: ts };
+}
+
+// Reading of one connection as sent to the watch, or null without a
+// measurement; history holds the graph's earlier readings when fetched
+function toPatientReading(connection, measurement, history) {
+  var reading = toReading(measurement);
+  if (!reading) {
+    return null;
+  }
+
+  reading.id = connection.patientId;
+  reading.initials = ((connection.firstName || '').charAt(0) + (connection.lastName || '').charAt(0)).toUpperCase();
+  reading.history = (history || []).map(toReading).filter(function(point) { return point !== null; });
+  return reading;
+}
+
+// Helper function for XHR requests (shared by the glucose sources)
+function xhrRequest(url, method, headers, body) {
+  // Traced and logged without host, query (tokens) and patient ids
+  var path = url.replace(/^https?:\/\/[^\/]+/, '').replace(/\?.*$/, '').replace(/connections\/[^\/]+/, 'connections/{id}');
+  var startedAt = Date.now();
+  trace('xhr', { method: method, path: path });
+  return new Promise(function(resolve, reject) {
+    var xhr = new XMLHttpRequest();
+    function traceDone(status) {
+      trace('xhrDone', { path: path, status: status, ms: Date.now() - startedAt });
+    }
+    xhr.open(method, url, true);
+    
+    for (var key in headers) {
+      if (headers.hasOwnProperty(key)) {
+        xhr.setRequestHeader(key, headers[key]);
+      }
+    }
+    
+    xhr.onload = function() {
+      traceDone(xhr.status);
+      log.debug("XHR response: " + xhr.status + " from " + path);
+      if (xhr.status >= 200 && xhr.status < 300) {
+        try {
+          var json = JSON.parse(xhr.responseText);
+          resolve({ status: xhr.status, ok: true, json: json });
+        } catch (e) {
+          log.error("JSON parse error: " + e.message);
+          reject(new Error("JSON parse error"));
+        }
+      } else {
+        log.warn("XHR error status: " + xhr.status);
+        reject(new Error("HTTP " + xhr.status));
+      }
+    };
+    
+    xhr.onerror = function() {
+      traceDone('error');
+      log.warn("XHR network error");
+      reject(new Error("Network error"));
+    };
+    
+    xhr.ontimeout = function() {
+      traceDone('timeout');
+      log.warn("XHR timeout");
+      reject(new Error("Timeout"));
+    };
+    
+    xhr.timeout = 30000;
+    
+    if (body) {
+      xhr.send(body);
+    } else {
+      xhr.send();
+    }
+  });
+}
+
 // Fetch Glucose
 function fetchGlucoseFromLibreLinkUp(email, password) {
   if (!email || !password) {
-    console.log("Credentials fehlen");
+    log.warn("Credentials fehlen");
     return Promise.resolve(null);
   }
 
-  console.log("Starte LibreLinkUp Login...");
-  console.log("Email: " + email.substring(0, 3) + "***");
+  log.info("Starte LibreLinkUp Login...");
+  log.debug("Email: " + email.substring(0, 3) + "***");
 
   // Always use DE region
   var baseUrl = "https://api-de.libreview.io";
@@ -475,74 +1047,26 @@ function fetchGlucoseFromLibreLinkUp(email, password) {
     "version": API.VERSION
   };
 
-  // Helper function for XHR requests
-  function xhrRequest(url, method, headers, body) {
-    return new Promise(function(resolve, reject) {
-      var xhr = new XMLHttpRequest();
-      xhr.open(method, url, true);
-      
-      for (var key in headers) {
-        if (headers.hasOwnProperty(key)) {
-          xhr.setRequestHeader(key, headers[key]);
-        }
-      }
-      
-      xhr.onload = function() {
-        console.log("XHR response: " + xhr.status + " from " + url);
-        if (xhr.status >= 200 && xhr.status < 300) {
-          try {
-            var json = JSON.parse(xhr.responseText);
-            resolve({ status: xhr.status, ok: true, json: json });
-          } catch (e) {
-            console.log("JSON parse error: " + e.message);
-            reject(new Error("JSON parse error"));
-          }
-        } else {
-          console.log("XHR error status: " + xhr.status);
-          reject(new Error("HTTP " + xhr.status));
-        }
-      };
-      
-      xhr.onerror = function() {
-        console.log("XHR network error");
-        reject(new Error("Network error"));
-      };
-      
-      xhr.ontimeout = function() {
-        console.log("XHR timeout");
-        reject(new Error("Timeout"));
-      };
-      
-      xhr.timeout = 30000;
-      
-      if (body) {
-        xhr.send(body);
-      } else {
-        xhr.send();
-      }
-    });
-  }
-
   // 1️⃣ Login
   return xhrRequest(baseUrl + "/llu/auth/login", "POST", loginHeaders, JSON.stringify({ email: email, password: password }))
     .then(function(result) {
       var loginJson = result.json;
 
-      console.log("Processing login result, status: " + loginJson.status);
+      log.debug("Processing login result, status: " + loginJson.status);
       if (loginJson.status !== 0) {
-        console.log("Login failed: json.status=" + loginJson.status);
+        log.warn("Login failed: json.status=" + loginJson.status);
         throw new Error("Login fehlgeschlagen");
       }
 
       token = loginJson.data && loginJson.data.authTicket && loginJson.data.authTicket.token;
       var userId = loginJson.data && loginJson.data.user && loginJson.data.user.id;
-      console.log("Token present: " + !!token + ", userId present: " + !!userId);
+      log.debug("Token present: " + !!token + ", userId present: " + !!userId);
       if (!token || !userId) {
         throw new Error("Token oder User ID fehlt");
       }
 
       accountId = sha256Hex(userId);
-      console.log("AccountId generated, fetching connections...");
+      log.debug("AccountId generated, fetching connections...");
 
       // 2️⃣ Connections abrufen
       authHeaders = {
@@ -557,52 +1081,156 @@ function fetchGlucoseFromLibreLinkUp(email, password) {
     })
     .then(function(result) {
       var connJson = result.json;
-      console.log("Connections response status: " + connJson.status);
+      log.debug("Connections response status: " + connJson.status);
       if (!connJson.data || !connJson.data.length) {
         throw new Error("Keine Connections gefunden");
       }
 
-      var connection = connJson.data[0];
-      console.log("Connection found, patientId: " + connection.patientId);
+      // 3️⃣ Letzte Messung jeder Connection auslesen; nur wo sie fehlt den
+      // Graph abfragen, alle Graphen gleichzeitig
+      var connections = connJson.data.slice(0, MAX_PATIENTS);
+      log.info("Connections found: " + connJson.data.length);
 
-      // 3️⃣ Letzte Messung auslesen
-      var measurement = pickMeasurement(connection);
+      return Promise.all(connections.map(function(connection) {
+        var measurement = pickMeasurement(connection);
+        if (measurement && (measurement.ValueInMgPerDl || measurement.Value)) {
+          return toPatientReading(connection, measurement);
+        }
 
-      // Wenn keine Messung vorhanden, Graph abfragen
-      if (!measurement || (!measurement.ValueInMgPerDl && !measurement.Value)) {
-        console.log("No direct measurement, fetching graph...");
-        var patientId = connection.patientId;
-        return xhrRequest(baseUrl + "/llu/connections/" + patientId + "/graph", "GET", authHeaders, null)
+        log.debug("No direct measurement for " + connection.patientId + ", fetching graph...");
+        return xhrRequest(baseUrl + "/llu/connections/" + connection.patientId + "/graph", "GET", authHeaders, null)
           .then(function(graphResult) {
-            console.log("Graph response received");
-            var connGraph = graphResult.json.data && graphResult.json.data.connection;
-            return pickMeasurement(connGraph);
+            var graph = graphResult.json.data || {};
+            return toPatientReading(connection, pickMeasurement(graph.connection), graph.graphData);
+          })
+          .catch(function(err) {
+            // One patient's graph failing must not hide the others
+            log.warn("Graph fetch failed for " + connection.patientId + ": " + err.message);
+            return null;
           });
-      }
-
-      return measurement;
+      }));
     })
-    .then(function(measurement) {
-      if (!measurement) {
+    .then(function(readings) {
+      var patients = readings.filter(function(reading) { return reading !== null; });
+      if (!patients.length) {
         throw new Error("Keine Messung gefunden");
       }
 
-      var value = measurement.ValueInMgPerDl || measurement.Value;
-      var trend = measurement.TrendArrow !== undefined ? measurement.TrendArrow : (measurement.Trend !== undefined ? measurement.Trend : -1);
-      var tsString = measurement.Timestamp || measurement.FactoryTimestamp;
-      var ts = tsString ? Math.floor(new Date(tsString).getTime() / 1000) : Math.floor(Date.now() / 1000);
+      var primary = patients[0];
+      log.info("Measurement extracted: value=" + primary.value + ", trend=" + primary.trend +
+               ", patients=" + patients.length);
+      return { value: primary.value, trend: primary.trend, ts: primary.ts, patients: patients };
+    });
+}
 
-      console.log("Measurement extracted: value=" + value + ", trend=" + trend);
-      return { value: value, trend: trend, ts: ts };
-    })
-    .catch(function(err) {
-      console.log("Fetch fehlgeschlagen: " + err.message);
+// Nightscout (or any server with its API): entries newer than a reading we
+// already have are asked for with find[date][$gt], so refreshes download only
+// new ones. Point it at a local server to run without the cloud.
+var NIGHTSCOUT_TREND = {
+  DoubleDown: 1, SingleDown: 1, FortyFiveDown: 2, Flat: 3,
+  FortyFiveUp: 4, SingleUp: 5, DoubleUp: 5
+};
+
+function fetchFromNightscout(credentials, since) {
+  var url = (credentials.nightscoutUrl || '').replace(/\/+$/, '');
+  if (!url) {
+    return Promise.reject(new Error('Nightscout URL missing'));
+  }
+
+  var query = '?count=' + (since ? STORE_MAX_READINGS : 1);
+  if (since) {
+    query += '&' + encodeURIComponent('find[date][$gt]') + '=' + since * 1000;
+  }
+  if (credentials.nightscoutToken) {
+    query += '&token=' + encodeURIComponent(credentials.nightscoutToken);
+  }
+
+  return xhrRequest(url + '/api/v1/entries/sgv.json' + query, 'GET', { 'Accept': 'application/json' }, null)
+    .then(function(result) {
+      var readings = (Array.isArray(result.json) ? result.json : []).filter(function(entry) {
+        return entry.sgv > 0 && entry.date > 0;
+      }).map(function(entry) {
+        var trend = NIGHTSCOUT_TREND[entry.direction];
+        return { value: entry.sgv, trend: trend !== undefined ? trend : -1, ts: Math.floor(entry.date / 1000) };
+      }).sort(function(a, b) { return b.ts - a.ts; });
+      log.info('Nightscout entries since ' + since + ': ' + readings.length);
+
+      // Nothing new still names the patient, so the store keeps its readings
+      var patient = { id: 'nightscout', initials: '', history: readings.slice(1) };
+      if (readings.length) {
+        patient.value = readings[0].value;
+        patient.trend = readings[0].trend;
+        patient.ts = readings[0].ts;
+      }
+      return { value: patient.value, trend: patient.trend, ts: patient.ts, patients: [patient] };
+    });
+}
+
+// Glucose sources. Each resolves with { value, trend, ts, patients } (patients
+// as from toPatientReading, [0] shown first; a patient without ts brought
+// nothing new) or null when the fetch failed:
+//   fetchLatest(credentials)     the newest reading of every patient
+//   fetchSince(credentials, ts)  also every reading newer than ts (in
+//                                patients[].history) where the backend can
+//                                filter; LibreLinkUp only has snapshots
+//   health()                     { ok, failures, lastSuccessAt, lastError }
+function makeGlucoseSource(name, fetchLatest, fetchSince) {
+  var state = { ok: true, failures: 0, lastSuccessAt: 0, lastError: null };
+
+  function tracked(promise) {
+    return promise.then(function(data) {
+      if (!data) {
+        throw new Error('No data');
+      }
+      state.ok = true;
+      state.failures = 0;
+      state.lastSuccessAt = Date.now();
+      state.lastError = null;
+      return data;
+    }).catch(function(err) {
+      state.ok = false;
+      state.failures++;
+      state.lastError = err.message;
+      log.error(name + ' fetch failed (' + state.failures + ' in a row): ' + err.message);
       return null;
     });
+  }
+
+  return {
+    name: name,
+    fetchLatest: function(credentials) {
+      return tracked(fetchLatest(credentials));
+    },
+    fetchSince: function(credentials, ts) {
+      return tracked(fetchSince(credentials, ts));
+    },
+    health: function() {
+      return { ok: state.ok, failures: state.failures, lastSuccessAt: state.lastSuccessAt, lastError: state.lastError };
+    }
+  };
 }
 
+function fetchLatestFromLibreLinkUp(credentials) {
+  return fetchGlucoseFromLibreLinkUp(credentials.email, credentials.password);
+}
+
+var GLUCOSE_SOURCES = {
+  librelinkup: makeGlucoseSource('LibreLinkUp', fetchLatestFromLibreLinkUp, fetchLatestFromLibreLinkUp),
+  nightscout: makeGlucoseSource('Nightscout', function(credentials) {
+    return fetchFromNightscout(credentials, 0);
+  }, fetchFromNightscout)
+};
+
+function glucoseSource(credentials) {
+  return GLUCOSE_SOURCES[credentials.source] || GLUCOSE_SOURCES.librelinkup;
+}
+
+Pebble.sourceHealth = function() {
+  return glucoseSource(getCredentials()).health();
+};
+
 function logError(event) {
-  console.log('Unable to deliver message with transactionId=' +
+  log.error('Unable to deliver message with transactionId=' +
               event.data.transactionId + '; Error: ' + JSON.stringify(event.error));
 }
 
@@ -612,23 +1240,27 @@ Pebble.addEventListener("showConfiguration", showConfiguration);
 Pebble.addEventListener("webviewclosed", webviewclosed);
 Pebble.addEventListener("appmessage", appmessage);
 
-// Automatic glucose refresh interval (5 minutes in milliseconds)
+// Automatic glucose refresh: at the watch's own request interval (reported
+// with its requests, 5 minutes until the first) and restarted by every
+// request, so a watch that asks on its own is not woken in between
 var GLUCOSE_REFRESH_INTERVAL_MS = 5 * 60 * 1000;
+var glucoseRefreshIntervalMs = GLUCOSE_REFRESH_INTERVAL_MS;
 var glucoseRefreshTimer = null;
 
 // Function to fetch and send glucose data proactively
 function refreshGlucoseData() {
-  console.log('Auto-refresh: fetching glucose data');
-  // Force refresh to get latest data from API (not cache)
+  trace('timer', { name: 'refresh' });
+  log.info('Auto-refresh: fetching glucose data');
+  // Force refresh to get latest data from API (not the reading store)
   getGlucoseData(true).then(function(data) {
     if (data) {
-      updateGlucoseData(data.value, data.trend, data.ts);
-      console.log('Auto-refresh: glucose data sent to watch');
+      updateGlucoseData(data.value, data.trend, data.ts, data.patients);
+      log.info('Auto-refresh: glucose data sent to watch');
     } else {
-      console.log('Auto-refresh: no glucose data available');
+      log.warn('Auto-refresh: no glucose data available');
     }
   }).catch(function(err) {
-    console.log('Auto-refresh error: ' + err.message);
+    log.warn('Auto-refresh error: ' + err.message);
   });
 }
 
@@ -637,28 +1269,50 @@ function startGlucoseRefreshTimer() {
   if (glucoseRefreshTimer) {
     clearInterval(glucoseRefreshTimer);
   }
-  glucoseRefreshTimer = setInterval(refreshGlucoseData, GLUCOSE_REFRESH_INTERVAL_MS);
-  console.log('Glucose refresh timer started (interval: ' + (GLUCOSE_REFRESH_INTERVAL_MS / 1000) + 's)');
+  glucoseRefreshTimer = setInterval(refreshGlucoseData, glucoseRefreshIntervalMs);
+  log.debug('Glucose refresh timer started (interval: ' + (glucoseRefreshIntervalMs / 1000) + 's)');
+}
+
+function followWatchInterval(minutes) {
+  if (minutes) {
+    glucoseRefreshIntervalMs = Math.max(GLUCOSE_REFRESH_INTERVAL_MS, minutes * 60 * 1000);
+  }
+  if (glucoseRefreshTimer) {
+    startGlucoseRefreshTimer();
+  }
 }
 
 // Send initial configuration on ready
 onReady(function(event) {
+  // Skip the settings when the watch acknowledged these already; its
+  // requests report its settings hash should it have lost them
   var message = prepareConfiguration(getOptions());
-  transmitConfiguration(message);
+  if (localStorage.getItem(SETTINGS_HASH_KEY) !== String(settingsHash(message))) {
+    transmitConfiguration(message);
+  } else {
+    log.info('Watch has the current settings');
+  }
   
-  // Use cache on startup for faster loading
+  // Use the reading store on startup for faster loading
   getGlucoseData(false).then(function(data) {
     if (data) {
-      updateGlucoseData(data.value, data.trend, data.ts);
+      updateGlucoseData(data.value, data.trend, data.ts, data.patients);
     } else {
-      console.log('No glucose data fetched at startup');
+      log.warn('No glucose data fetched at startup');
     }
   }).catch(function(err) {
-    console.log('Error fetching glucose at startup: ' + err.message);
+    log.warn('Error fetching glucose at startup: ' + err.message);
   });
   
   // Start automatic glucose refresh timer
   // This ensures the watch always gets updated data even if it doesn't request it
   startGlucoseRefreshTimer();
+
+  // Collect the watch's hourly activity counters
+  requestPowerLedger();
+  setInterval(function() {
+    trace('timer', { name: 'ledger' });
+    requestPowerLedger();
+  }, LEDGER_REQUEST_INTERVAL_MS);
 });
 
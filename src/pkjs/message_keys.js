@@ -3,8 +3,19 @@ module.exports = {
   INVERT_KEY: 0,
   TEXT_ALIGN_KEY: 1,
   LANGUAGE_KEY: 2,
+  ESTIMATE_KEY: 3,
+  POWER_KEY: 4,
   KEY_GLUCOSE_VALUE: 10,
   KEY_TREND_VALUE: 11,
   KEY_REQUEST_DATA: 12,
-  KEY_TIMESTAMP: 13
+  KEY_TIMESTAMP: 13,
+  KEY_NOT_MODIFIED: 14,
+  KEY_LEDGER_REQUEST: 15,
+  KEY_LEDGER_DATA: 16,
+  KEY_SETTINGS_HASH: 17,
+  KEY_PATIENTS: 18,
+  KEY_DISPLAY_AGE: 19,
+  KEY_DISPLAY_DELAY: 20,
+  KEY_PATIENT_TIMESTAMPS: 21,
+  KEY_REQUEST_INTERVAL: 22
 };
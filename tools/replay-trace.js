@@ -0,0 +1,287 @@
+// Replays a trace captured with TRACE_CAPTURE (src/pkjs/index.js) against the
+// phone app, with the Pebble runtime, localStorage and XMLHttpRequest faked:
+//
+//   node tools/replay-trace.js trace.json [--speed N]
+//
+// The trace may be the JSON itself or the "TRACE {...}" log line. Messages
+// from the watch arrive at their recorded times, sends are acked or nacked
+// as they were, XHRs answer with the recorded status after the recorded
+// duration, and LibreLinkUp or Nightscout bodies (the trace's source) are
+// rebuilt from the traced readings.
+// --speed runs the clock (and the app's own timers) N times faster.
+var fs = require('fs');
+var path = require('path');
+var vm = require('vm');
+
+var PKJS_DIR = path.join(__dirname, '..', 'src', 'pkjs');
+var END_MARGIN_MS = 10 * 1000;   // keep running after the last event for late sends
+var DUPLICATE_WINDOW_MS = 1000;  // equal payloads sent this close are reported
+
+function parseArgs(argv) {
+  var args = { file: null, speed: 1 };
+  for (var i = 0; i < argv.length; i++) {
+    if (argv[i] === '--speed') {
+      args.speed = Number(argv[++i]) || 1;
+    } else {
+      args.file = argv[i];
+    }
+  }
+  if (!args.file) {
+    console.error('Usage: node tools/replay-trace.js trace.json [--speed N]');
+    process.exit(1);
+  }
+  return args;
+}
+
+function loadTrace(file) {
+  var text = fs.readFileSync(file, 'utf8');
+  var start = text.indexOf('TRACE ');
+  var trace = JSON.parse(start >= 0 ? text.slice(start + 6) : text);
+  trace.events.sort(function(a, b) { return a.t - b.t; });
+  return trace;
+}
+
+var args = parseArgs(process.argv.slice(2));
+var trace = loadTrace(args.file);
+var events = trace.events;
+
+// Virtual clock: starts at the trace's load time, runs args.speed times faster
+var realStart = Date.now();
+function now() {
+  return realStart + (Date.now() - realStart) * args.speed;
+}
+
+class ReplayDate extends Date {
+  constructor() {
+    if (arguments.length) {
+      super(...arguments);
+    } else {
+      super(now());
+    }
+  }
+  static now() {
+    return now();
+  }
+}
+
+function later(fn, ms) {
+  return setTimeout(fn, Math.max(0, ms) / args.speed);
+}
+
+function at(t, fn) {
+  return later(fn, t - (now() - realStart));
+}
+
+// Recorded outcomes, consumed in order
+var sendOutcomes = [];
+var sendsById = {};
+var xhrResults = {};
+var fetchResults = [];
+events.forEach(function(event) {
+  if (event.type === 'send') {
+    sendsById[event.id] = event;
+  } else if (event.type === 'ack' || event.type === 'nack') {
+    var send = sendsById[event.id];
+    sendOutcomes.push({ ack: event.type === 'ack', error: event.error, delay: send ? event.t - send.t : 0 });
+  } else if (event.type === 'xhrDone') {
+    (xhrResults[event.path] = xhrResults[event.path] || []).push(event);
+  } else if (event.type === 'fetch') {
+    fetchResults.push(event.patients);
+  }
+});
+
+// What the replay did, for the report
+var replayed = { sends: [], acks: 0, nacks: 0, xhrs: 0, inbound: 0, firstGlucoseAt: null };
+
+function logEvent(text) {
+  console.log(('      ' + Math.round(now() - realStart)).slice(-7) + ' ms  ' + text);
+}
+
+var listeners = {};
+var Pebble = {
+  addEventListener: function(name, fn) {
+    (listeners[name] = listeners[name] || []).push(fn);
+  },
+  sendAppMessage: function(message, onAck, onNack) {
+    var outcome = sendOutcomes.shift() || { ack: true, delay: 0 };
+    var payload = JSON.stringify(message);
+    var sentAt = now() - realStart;
+    var duplicate = replayed.sends.some(function(send) {
+      return send.payload === payload && sentAt - send.t < DUPLICATE_WINDOW_MS;
+    });
+    replayed.sends.push({ t: sentAt, payload: payload, duplicate: duplicate });
+    if (replayed.firstGlucoseAt === null && message[KEYS.KEY_GLUCOSE_VALUE] !== undefined) {
+      replayed.firstGlucoseAt = sentAt;
+    }
+    logEvent('send ' + payload + (duplicate ? '  (duplicate)' : ''));
+
+    later(function() {
+      if (outcome.ack) {
+        replayed.acks++;
+        logEvent('ack');
+        onAck({ data: { transactionId: replayed.sends.length } });
+      } else {
+        replayed.nacks++;
+        logEvent('nack ' + JSON.stringify(outcome.error));
+        onNack({ data: { transactionId: replayed.sends.length }, error: outcome.error });
+      }
+    }, outcome.delay);
+  },
+  openURL: function() {}
+};
+
+// Nightscout directions for the watch's trend values
+var NIGHTSCOUT_DIRECTIONS = { 1: 'SingleDown', 2: 'FortyFiveDown', 3: 'Flat', 4: 'FortyFiveUp', 5: 'SingleUp' };
+
+// Answers rebuilt from the traced fetch results
+function responseBody(urlPath, status) {
+  if (/\/sgv\.json$/.test(urlPath)) {
+    // The trace keeps only the newest reading; none means nothing was new
+    return (fetchResults.shift() || []).map(function(patient) {
+      return { sgv: patient.value, date: patient.ts * 1000, direction: NIGHTSCOUT_DIRECTIONS[patient.trend] || 'NONE' };
+    });
+  }
+  if (urlPath === '/llu/auth/login') {
+    if (status < 200 || status >= 300) {
+      fetchResults.shift();  // that fetch ended here
+    }
+    return { status: 0, data: { authTicket: { token: 'replay' }, user: { id: 'replay' } } };
+  }
+  if (urlPath === '/llu/connections') {
+    var patients = fetchResults.shift() || [];
+    return { status: 0, data: patients.map(function(patient, i) {
+      return {
+        patientId: 'patient' + i,
+        firstName: (patient.initials || '').charAt(0),
+        lastName: (patient.initials || '').charAt(1),
+        glucoseMeasurement: {
+          ValueInMgPerDl: patient.value,
+          TrendArrow: patient.trend,
+          Timestamp: new Date(patient.ts * 1000).toISOString()
+        }
+      };
+    }) };
+  }
+  return { status: 0, data: { connection: {}, graphData: [] } };
+}
+
+// Requests whose failure fails the whole fetch (graph data is optional)
+function endsFetch(urlPath) {
+  return urlPath === '/llu/auth/login' || urlPath === '/llu/connections' || /\/sgv\.json$/.test(urlPath);
+}
+
+function FakeXMLHttpRequest() {}
+FakeXMLHttpRequest.prototype.open = function(method, url) {
+  this.urlPath = url.replace(/^https?:\/\/[^\/]+/, '').replace(/\?.*$/, '').replace(/connections\/[^\/]+/, 'connections/{id}');
+};
+FakeXMLHttpRequest.prototype.setRequestHeader = function() {};
+FakeXMLHttpRequest.prototype.send = function() {
+  var xhr = this;
+  var result = (xhrResults[xhr.urlPath] || []).shift() || { status: 200, ms: 0 };
+  replayed.xhrs++;
+  logEvent('xhr ' + xhr.urlPath);
+  later(function() {
+    logEvent('xhr done ' + xhr.urlPath + ' ' + result.status);
+    if ((result.status === 'error' || result.status === 'timeout') && endsFetch(xhr.urlPath)) {
+      fetchResults.shift();
+    }
+    if (result.status === 'error') {
+      xhr.onerror();
+    } else if (result.status === 'timeout') {
+      xhr.ontimeout();
+    } else {
+      xhr.status = result.status;
+      xhr.responseText = JSON.stringify(responseBody(xhr.urlPath, result.status));
+      xhr.onload();
+    }
+  }, result.ms);
+};
+
+// Options selecting the source the trace was captured with (older traces
+// did not record it and were all LibreLinkUp)
+var storage = { options: JSON.stringify({
+  source: trace.source || 'librelinkup',
+  email: 'replay@example.com',
+  password: 'replay',
+  nightscoutUrl: 'https://nightscout.replay'
+}) };
+var localStorage = {
+  getItem: function(key) { return storage.hasOwnProperty(key) ? storage[key] : null; },
+  setItem: function(key, value) { storage[key] = String(value); },
+  removeItem: function(key) { delete storage[key]; }
+};
+
+var KEYS = require(path.join(PKJS_DIR, 'message_keys.js'));
+
+function sandboxRequire(name) {
+  if (name === 'message_keys') {
+    return KEYS;
+  }
+  if (name === 'pebble-clay') {
+    return function() { this.generateUrl = function() { return ''; }; };
+  }
+  return require(path.join(PKJS_DIR, name));
+}
+
+var sandbox = {
+  console: console,
+  Date: ReplayDate,
+  Promise: Promise,
+  XMLHttpRequest: FakeXMLHttpRequest,
+  Pebble: Pebble,
+  localStorage: localStorage,
+  require: sandboxRequire,
+  module: { exports: {} },
+  setTimeout: later,
+  clearTimeout: clearTimeout,
+  setInterval: function(fn, ms) { return setInterval(fn, ms / args.speed); },
+  clearInterval: clearInterval
+};
+
+var source = fs.readFileSync(path.join(PKJS_DIR, 'index.js'), 'utf8');
+vm.runInNewContext(source, sandbox, { filename: 'index.js' });
+
+function dispatch(name, event) {
+  (listeners[name] || []).forEach(function(fn) { fn(event); });
+}
+
+// Drive the recorded watch side
+var ready = events.filter(function(event) { return event.type === 'ready'; })[0];
+at(ready ? ready.t : 0, function() {
+  logEvent('ready');
+  dispatch('ready', {});
+});
+events.forEach(function(event) {
+  if (event.type === 'in') {
+    at(event.t, function() {
+      replayed.inbound++;
+      logEvent('in ' + JSON.stringify(event.payload));
+      dispatch('appmessage', { payload: event.payload });
+    });
+  }
+});
+
+var recordedSends = events.filter(function(event) { return event.type === 'send'; }).length;
+var lastT = events.length ? events[events.length - 1].t : 0;
+at(lastT + END_MARGIN_MS, function() {
+  var duplicates = replayed.sends.filter(function(send) { return send.duplicate; }).length;
+  console.log('');
+  console.log('Replayed ' + events.length + ' events (trace of version ' + trace.version + ') at ' + args.speed + 'x');
+  console.log('  inbound messages: ' + replayed.inbound);
+  console.log('  sends: ' + replayed.sends.length + ' (recorded ' + recordedSends + '), acks: ' +
+              replayed.acks + ', nacks: ' + replayed.nacks + ', duplicates: ' + duplicates);
+  console.log('  xhrs: ' + replayed.xhrs);
+  console.log('  first glucose send: ' + (replayed.firstGlucoseAt === null ? 'none' : Math.round(replayed.firstGlucoseAt) + ' ms'));
+
+  // Data age per stage, as the app's freshness histograms saw the replay
+  var freshness = Pebble.freshnessReport();
+  Object.keys(freshness).forEach(function(stage) {
+    var buckets = freshness[stage].filter(function(bucket) { return bucket.count > 0; });
+    if (buckets.length) {
+      console.log('  ' + stage + ': ' + buckets.map(function(bucket) {
+        return (bucket.upToMs === null ? 'longer' : '<=' + bucket.upToMs + 'ms') + ' x' + bucket.count;
+      }).join(', '));
+    }
+  });
+  process.exit(0);
+});
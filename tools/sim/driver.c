@@ -0,0 +1,428 @@
+#include "sim.h"
+#include "AppRequests.h"
+
+// Runs the watchface on the fake runtime through a scripted day and reports
+// what it cost, optionally against a baseline:
+//
+//   textwatch-sim [-v] [-t] [-c] [-b baseline] [-w baseline] [-p percent] script
+//
+//   -v  print the face's log      -t  print every runtime call
+//   -c  list runtime calls        -b  compare with a baseline, exit 1 on regressions
+//   -w  write the run's metrics as the new baseline
+//   -p  allowed increase over the baseline in percent (default 10)
+//
+// Script commands, one per line, '#' starts a comment:
+//
+//   start 2026-03-02 07:00   start of the run (UTC); must come first
+//   run 90s | 30m | 2h       let time pass
+//   until 23:30              let time pass until the clock shows 23:30
+//   tap                      tap the watch
+//   click up|select|down     press a button (handlers exist in DEBUG builds)
+//   hold up|select|down      long press
+//   battery 15 [charging]    new battery state
+//   phone on|off             Bluetooth connection to the phone
+//   readings 120 [5]         the phone answers requests from a sensor that starts
+//                            at 120 mg/dL and has a new reading every 5 minutes
+//   readings off             the phone stops answering requests
+//   glucose 140 3            the phone pushes a reading (mg/dL, trend) now
+//   setting 4 2              the phone sends a setting (key, value)
+
+// The face's main() (built with -Dmain=watchface_main)
+int watchface_main(void);
+
+#define MAX_LINE 256
+#define PHONE_FETCH_MS 1200        // Request to answer: the phone fetches from the cloud
+#define PHONE_MESSAGE_SIZE 64
+#define SENSOR_SWING 60            // mg/dL up and down around the start value
+#define SENSOR_SWING_READINGS 12   // Readings from the bottom to the top of a swing
+
+typedef struct {
+  int line;
+  char text[MAX_LINE];
+} Command;
+
+static Command *s_commands = NULL;
+static int s_command_count = 0;
+static const char *s_script_name;
+static int s_failed_line = 0;
+
+// The phone: answers requests from a simulated sensor
+static bool s_readings_on = false;
+static int s_sensor_start_value = 0;
+static int s_sensor_interval_s = 5 * 60;
+static time_t s_sensor_start = 0;
+static uint32_t s_requests = 0;
+
+static int sensor_value(int index) {
+  const int phase = index % (2 * SENSOR_SWING_READINGS);
+  const int step = phase < SENSOR_SWING_READINGS ? phase : 2 * SENSOR_SWING_READINGS - phase;
+  return s_sensor_start_value + SENSOR_SWING * step / SENSOR_SWING_READINGS;
+}
+
+// Trend arrow from the change since the previous reading, in mg/dL per minute
+static int sensor_trend(int index) {
+  if (index == 0) {
+    return TREND_FLAT;
+  }
+  const int delta = (sensor_value(index) - sensor_value(index - 1)) * 60 / s_sensor_interval_s;
+  if (delta > 2) return TREND_UP;
+  if (delta > 1) return TREND_UP_RIGHT;
+  if (delta >= -1) return TREND_FLAT;
+  if (delta >= -2) return TREND_DOWN_RIGHT;
+  return TREND_DOWN;
+}
+
+static void phone_send_reading(int value, int trend, time_t timestamp, uint32_t delay_ms) {
+  uint8_t buffer[PHONE_MESSAGE_SIZE];
+  DictionaryIterator iter;
+  dict_write_begin(&iter, buffer, sizeof(buffer));
+  dict_write_int32(&iter, KEY_GLUCOSE_VALUE, value);
+  dict_write_int32(&iter, KEY_TREND_VALUE, trend);
+  dict_write_int32(&iter, KEY_TIMESTAMP, (int32_t)timestamp);
+  sim_deliver(buffer, dict_write_end(&iter), delay_ms);
+}
+
+static void phone_received(DictionaryIterator *message) {
+  if (!dict_find(message, KEY_REQUEST_DATA)) {
+    return;
+  }
+  s_requests++;
+  if (!s_readings_on) {
+    return;
+  }
+
+  const time_t now = (time_t)(sim_now_ms() / 1000);
+  const int index = (int)((now - s_sensor_start) / s_sensor_interval_s);
+  const time_t timestamp = s_sensor_start + (time_t)index * s_sensor_interval_s;
+  const Tuple *newest = dict_find(message, KEY_TIMESTAMP);
+  if (newest && newest->value->int32 >= timestamp) {
+    uint8_t buffer[PHONE_MESSAGE_SIZE];
+    DictionaryIterator iter;
+    dict_write_begin(&iter, buffer, sizeof(buffer));
+    dict_write_uint8(&iter, KEY_NOT_MODIFIED, 1);
+    sim_deliver(buffer, dict_write_end(&iter), PHONE_FETCH_MS);
+    return;
+  }
+  phone_send_reading(sensor_value(index), sensor_trend(index), timestamp, PHONE_FETCH_MS);
+}
+
+// Script
+
+static bool parse_duration(const char *text, uint32_t *ms) {
+  char unit = 's';
+  unsigned long amount;
+  if (sscanf(text, "%lu%c", &amount, &unit) < 1) {
+    return false;
+  }
+  switch (unit) {
+    case 's': *ms = amount * 1000; return true;
+    case 'm': *ms = amount * 60 * 1000; return true;
+    case 'h': *ms = amount * 60 * 60 * 1000; return true;
+    default: return false;
+  }
+}
+
+static bool parse_button(const char *text, ButtonId *button) {
+  if (strcmp(text, "up") == 0) *button = BUTTON_ID_UP;
+  else if (strcmp(text, "select") == 0) *button = BUTTON_ID_SELECT;
+  else if (strcmp(text, "down") == 0) *button = BUTTON_ID_DOWN;
+  else return false;
+  return true;
+}
+
+// Milliseconds until the clock next shows hour:minute
+static uint32_t ms_until(int hour, int minute) {
+  const time_t now = (time_t)(sim_now_ms() / 1000);
+  const struct tm *local = localtime(&now);
+  const int now_s = local->tm_hour * 3600 + local->tm_min * 60 + local->tm_sec;
+  int wait_s = hour * 3600 + minute * 60 - now_s;
+  if (wait_s <= 0) {
+    wait_s += 24 * 3600;
+  }
+  return (uint32_t)wait_s * 1000 - (uint32_t)(sim_now_ms() % 1000);
+}
+
+static bool run_command(const char *text) {
+  char name[16] = "";
+  char arg1[32] = "";
+  char arg2[32] = "";
+  const int count = sscanf(text, "%15s %31s %31s", name, arg1, arg2);
+  uint32_t ms;
+  int hour, minute, value, extra;
+  ButtonId button;
+
+  if (strcmp(name, "run") == 0 && count >= 2 && parse_duration(arg1, &ms)) {
+    sim_run_for(ms);
+  } else if (strcmp(name, "until") == 0 && count >= 2 && sscanf(arg1, "%d:%d", &hour, &minute) == 2) {
+    sim_run_for(ms_until(hour, minute));
+  } else if (strcmp(name, "tap") == 0) {
+    sim_tap();
+  } else if ((strcmp(name, "click") == 0 || strcmp(name, "hold") == 0) && count >= 2 && parse_button(arg1, &button)) {
+    if (!sim_click(button, name[0] == 'h')) {
+      fprintf(stderr, "%s: no handler for %s %s\n", s_script_name, name, arg1);
+    }
+  } else if (strcmp(name, "battery") == 0 && count >= 2 && sscanf(arg1, "%d", &value) == 1) {
+    sim_set_battery((uint8_t)value, count >= 3 && strcmp(arg2, "charging") == 0);
+  } else if (strcmp(name, "phone") == 0 && count >= 2 && (strcmp(arg1, "on") == 0 || strcmp(arg1, "off") == 0)) {
+    sim_set_connected(strcmp(arg1, "on") == 0);
+  } else if (strcmp(name, "readings") == 0 && count >= 2 && strcmp(arg1, "off") == 0) {
+    s_readings_on = false;
+  } else if (strcmp(name, "readings") == 0 && count >= 2 && sscanf(arg1, "%d", &value) == 1) {
+    s_readings_on = true;
+    s_sensor_start_value = value;
+    s_sensor_interval_s = (count >= 3 && sscanf(arg2, "%d", &extra) == 1 && extra > 0) ? extra * 60 : 5 * 60;
+    s_sensor_start = (time_t)(sim_now_ms() / 1000);
+  } else if (strcmp(name, "glucose") == 0 && count >= 3 && sscanf(arg1, "%d", &value) == 1
+             && sscanf(arg2, "%d", &extra) == 1) {
+    phone_send_reading(value, extra, (time_t)(sim_now_ms() / 1000), 0);
+  } else if (strcmp(name, "setting") == 0 && count >= 3 && sscanf(arg1, "%d", &value) == 1
+             && sscanf(arg2, "%d", &extra) == 1) {
+    uint8_t buffer[PHONE_MESSAGE_SIZE];
+    DictionaryIterator iter;
+    dict_write_begin(&iter, buffer, sizeof(buffer));
+    dict_write_int32(&iter, (uint32_t)value, extra);
+    sim_deliver(buffer, dict_write_end(&iter), 0);
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// app_event_loop: the rest of the script, then the face exits
+static void event_loop(void) {
+  for (int i = 1; i < s_command_count; i++) {
+    if (!run_command(s_commands[i].text)) {
+      s_failed_line = s_commands[i].line;
+      return;
+    }
+  }
+  // Let the last messages and transitions finish
+  sim_run_for(5 * 1000);
+}
+
+static bool load_script(const char *path) {
+  FILE *file = fopen(path, "r");
+  if (!file) {
+    perror(path);
+    return false;
+  }
+  char line[MAX_LINE];
+  int number = 0;
+  int capacity = 0;
+  while (fgets(line, sizeof(line), file)) {
+    number++;
+    char *comment = strchr(line, '#');
+    if (comment) {
+      *comment = '\0';
+    }
+    char *text = line + strspn(line, " \t");
+    text[strcspn(text, "\r\n")] = '\0';
+    if (!*text) {
+      continue;
+    }
+    if (s_command_count == capacity) {
+      capacity = capacity ? capacity * 2 : 64;
+      s_commands = realloc(s_commands, capacity * sizeof(Command));
+    }
+    s_commands[s_command_count].line = number;
+    snprintf(s_commands[s_command_count].text, MAX_LINE, "%s", text);
+    s_command_count++;
+  }
+  fclose(file);
+  return true;
+}
+
+static bool parse_start(const char *text, time_t *start) {
+  struct tm tm = { 0 };
+  if (sscanf(text, "start %d-%d-%d %d:%d", &tm.tm_year, &tm.tm_mon, &tm.tm_mday, &tm.tm_hour, &tm.tm_min) != 5) {
+    return false;
+  }
+  tm.tm_year -= 1900;
+  tm.tm_mon -= 1;
+  *start = mktime(&tm);
+  return *start != (time_t)-1;
+}
+
+// Metrics: what the baseline holds, lower is better for all of them
+
+typedef struct {
+  const char *name;
+  double value;
+} Metric;
+
+enum { MAX_METRICS = 16 };
+
+static int collect_metrics(const SimReport *report, Metric *metrics) {
+  const double hours = report->elapsed_s > 0 ? report->elapsed_s / 3600.0 : 1;
+  uint32_t allocations = 0;
+  uint32_t leaked = 0;
+  for (int kind = 0; kind < SIM_KINDS; kind++) {
+    allocations += report->allocations[kind];
+    leaked += report->live[kind];
+  }
+  int count = 0;
+  metrics[count++] = (Metric) { "heap_peak_bytes", report->heap_peak };
+  metrics[count++] = (Metric) { "allocations_per_hour", allocations / hours };
+  metrics[count++] = (Metric) { "leaked_objects", leaked };
+  metrics[count++] = (Metric) { "runtime_errors", report->api_errors };
+  metrics[count++] = (Metric) { "frames_per_hour", report->frames / hours };
+  metrics[count++] = (Metric) { "update_procs_per_hour", report->layer_draws / hours };
+  metrics[count++] = (Metric) { "graphics_calls_per_hour", report->graphics_calls / hours };
+  metrics[count++] = (Metric) { "animations_per_hour", report->animations_scheduled / hours };
+  metrics[count++] = (Metric) { "timer_wakeups_per_hour", report->timer_wakeups / hours };
+  metrics[count++] = (Metric) { "messages_sent_per_hour", report->messages_sent / hours };
+  metrics[count++] = (Metric) { "bytes_sent_per_hour", report->message_bytes_sent / hours };
+  metrics[count++] = (Metric) { "persist_writes_per_hour", report->persist_writes / hours };
+  return count;
+}
+
+static void print_report(const SimReport *report) {
+  const double hours = report->elapsed_s > 0 ? report->elapsed_s / 3600.0 : 1;
+  printf("Simulated %.1f h\n", report->elapsed_s / 3600.0);
+  printf("  objects (allocated/freed/live at exit):\n");
+  for (int kind = 0; kind < SIM_KINDS; kind++) {
+    printf("    %-20s %6lu %6lu %3lu\n", SIM_KIND_NAMES[kind], (unsigned long)report->allocations[kind],
+           (unsigned long)report->frees[kind], (unsigned long)report->live[kind]);
+  }
+  printf("  heap peak: %lu bytes\n", (unsigned long)report->heap_peak);
+  printf("  frames: %lu (%.1f/h), update procs: %lu, text layers drawn: %lu, graphics calls: %lu\n",
+         (unsigned long)report->frames, report->frames / hours, (unsigned long)report->layer_draws,
+         (unsigned long)report->text_draws, (unsigned long)report->graphics_calls);
+  printf("  animations: %lu scheduled (%.1f/h), %lu finished, %lu cancelled\n",
+         (unsigned long)report->animations_scheduled, report->animations_scheduled / hours,
+         (unsigned long)report->animations_finished, (unsigned long)report->animations_cancelled);
+  printf("  timer wakeups: %lu (%.1f/h), ticks: %lu\n", (unsigned long)report->timer_wakeups,
+         report->timer_wakeups / hours, (unsigned long)report->ticks);
+  printf("  messages: %lu sent (%lu bytes, %lu requests), %lu failed, %lu received (%lu bytes)\n",
+         (unsigned long)report->messages_sent, (unsigned long)report->message_bytes_sent,
+         (unsigned long)s_requests, (unsigned long)report->messages_failed,
+         (unsigned long)report->messages_received, (unsigned long)report->message_bytes_received);
+  printf("  persist writes: %lu (%lu bytes), worker messages: %lu\n", (unsigned long)report->persist_writes,
+         (unsigned long)report->persist_bytes_written, (unsigned long)report->worker_messages);
+  printf("  runtime errors: %lu\n", (unsigned long)report->api_errors);
+}
+
+static bool write_baseline(const char *path, const Metric *metrics, int count) {
+  FILE *file = fopen(path, "w");
+  if (!file) {
+    perror(path);
+    return false;
+  }
+  fprintf(file, "# Written by textwatch-sim -w; compared with -b\n");
+  for (int i = 0; i < count; i++) {
+    fprintf(file, "%s %.1f\n", metrics[i].name, metrics[i].value);
+  }
+  fclose(file);
+  return true;
+}
+
+// Leaks and runtime errors fail on their own; everything else may grow by
+// tolerance percent over the baseline
+static bool compare_baseline(const char *path, const Metric *metrics, int count, double tolerance) {
+  FILE *file = fopen(path, "r");
+  if (!file) {
+    perror(path);
+    return false;
+  }
+  bool ok = true;
+  char line[MAX_LINE];
+  printf("\n  %-26s %12s %12s\n", "against baseline", "baseline", "now");
+  while (fgets(line, sizeof(line), file)) {
+    char name[64];
+    double base;
+    if (line[0] == '#' || sscanf(line, "%63s %lf", name, &base) != 2) {
+      continue;
+    }
+    for (int i = 0; i < count; i++) {
+      if (strcmp(metrics[i].name, name) != 0) {
+        continue;
+      }
+      const bool regressed = metrics[i].value > base * (1 + tolerance / 100) + 0.05;
+      printf("  %-26s %12.1f %12.1f%s\n", name, base, metrics[i].value, regressed ? "  REGRESSION" : "");
+      ok &= !regressed;
+    }
+  }
+  fclose(file);
+  return ok;
+}
+
+int main(int argc, char **argv) {
+  const char *baseline = NULL;
+  const char *new_baseline = NULL;
+  double tolerance = 10;
+  bool print_calls = false;
+  int arg = 1;
+  for (; arg < argc && argv[arg][0] == '-'; arg++) {
+    const char option = argv[arg][1];
+    if (option == 'v') {
+      sim_set_log(true);
+    } else if (option == 't') {
+      sim_set_trace(true);
+    } else if (option == 'c') {
+      print_calls = true;
+    } else if ((option == 'b' || option == 'w' || option == 'p') && arg + 1 < argc) {
+      const char *value = argv[++arg];
+      if (option == 'b') baseline = value;
+      else if (option == 'w') new_baseline = value;
+      else tolerance = atof(value);
+    } else {
+      break;
+    }
+  }
+  if (arg != argc - 1) {
+    fprintf(stderr, "Usage: %s [-v] [-t] [-c] [-b baseline] [-w baseline] [-p percent] script\n", argv[0]);
+    return 2;
+  }
+
+  // Scripts give wall clock times; the watch shows UTC
+  setenv("TZ", "UTC", 1);
+  tzset();
+
+  s_script_name = argv[arg];
+  time_t start;
+  if (!load_script(s_script_name)) {
+    return 2;
+  }
+  if (s_command_count == 0 || !parse_start(s_commands[0].text, &start)) {
+    fprintf(stderr, "%s: the script must begin with start YYYY-MM-DD HH:MM\n", s_script_name);
+    return 2;
+  }
+
+  sim_start(start);
+  sim_set_send_handler(phone_received);
+  sim_set_event_loop(event_loop);
+  watchface_main();
+
+  if (s_failed_line) {
+    fprintf(stderr, "%s:%d: cannot run this line\n", s_script_name, s_failed_line);
+    return 2;
+  }
+
+  SimReport report;
+  sim_report(&report);
+  print_report(&report);
+  if (print_calls) {
+    printf("\n  runtime calls:\n");
+    sim_print_calls(stdout);
+  }
+
+  Metric metrics[MAX_METRICS];
+  const int count = collect_metrics(&report, metrics);
+  bool ok = true;
+  if (new_baseline) {
+    ok &= write_baseline(new_baseline, metrics, count);
+  }
+  if (baseline) {
+    ok &= compare_baseline(baseline, metrics, count, tolerance);
+  }
+  for (int kind = 0; kind < SIM_KINDS; kind++) {
+    if (report.live[kind] > 0) {
+      fprintf(stderr, "%lu %s left at exit\n", (unsigned long)report.live[kind], SIM_KIND_NAMES[kind]);
+      ok = false;
+    }
+  }
+  if (report.api_errors > 0) {
+    ok = false;
+  }
+  return ok ? 0 : 1;
+}
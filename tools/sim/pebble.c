@@ -0,0 +1,1675 @@
+#include <stdarg.h>
+#include "sim.h"
+
+// Fake Pebble runtime for the host simulator. Everything runs on a virtual
+// clock advanced by sim_run_for. Objects handed to the face are never
+// really freed: destroying one only marks it dead, so a later call on it
+// is reported instead of reading freed memory.
+
+#define SCREEN_WIDTH 144
+#define SCREEN_HEIGHT 168
+#define SIM_HEAP_SIZE (24 * 1024)    // App heap on aplite
+#define ANIMATION_FRAME_MS 33        // The animation service runs at about 30 fps
+#define SEND_LATENCY_MS 150          // From outbox_send to the ack or nack
+#define MAX_PERSIST_KEYS 64
+#define MAX_CALL_SITES 160
+
+#undef time
+
+const char *const SIM_KIND_NAMES[SIM_KINDS] = {
+  [SIM_LAYER] = "layers",
+  [SIM_TEXT_LAYER] = "text layers",
+  [SIM_WINDOW] = "windows",
+  [SIM_PROPERTY_ANIMATION] = "property animations",
+  [SIM_APP_TIMER] = "app timers"
+};
+
+typedef struct {
+  uint8_t kind;
+  bool alive;
+  size_t size;
+} SimObject;
+
+struct Layer {
+  SimObject object;
+  GRect frame;
+  bool hidden;
+  bool clips;
+  LayerUpdateProc update_proc;
+  Layer *parent;
+  Layer *first_child;
+  Layer *next_sibling;
+};
+
+struct TextLayer {
+  Layer layer;
+  const char *text;
+  GFont font;
+  GColor text_color;
+  GColor background_color;
+  GTextAlignment alignment;
+};
+
+struct Window {
+  SimObject object;
+  Layer root;
+  WindowHandlers handlers;
+  GColor background_color;
+  bool loaded;
+};
+
+struct Animation {
+  SimObject object;
+  uint32_t delay_ms;
+  uint32_t duration_ms;
+  AnimationCurve curve;
+  AnimationHandlers handlers;
+  void *context;
+  bool scheduled;
+  bool started;
+  int64_t start_ms;
+};
+
+struct PropertyAnimation {
+  Animation animation;
+  Layer *layer;
+  GRect from;
+  GRect to;
+  bool has_from;
+};
+
+struct AppTimer {
+  SimObject object;
+  int64_t due_ms;
+  uint64_t seq;
+  AppTimerCallback callback;
+  void *data;
+};
+
+struct GContext {
+  GColor stroke_color;
+  GColor fill_color;
+  GColor text_color;
+};
+
+struct SimFont {
+  const char *key;
+  uint8_t char_width;   // Average advance; close enough to decide line breaks
+  uint8_t height;
+};
+
+// Runtime events that are not app timers: message deliveries and send results
+typedef void (*SimEventHandler)(void *data, uint32_t size);
+typedef struct {
+  int64_t due_ms;
+  uint64_t seq;
+  SimEventHandler handler;
+  void *data;
+  uint32_t size;
+} SimEvent;
+
+typedef struct {
+  uint32_t key;
+  uint16_t length;
+  uint8_t data[PERSIST_DATA_MAX_LENGTH];
+} PersistEntry;
+
+typedef struct {
+  const char *name;
+  uint32_t count;
+} CallSite;
+
+static SimReport s_report;
+static int64_t s_start_ms;
+static int64_t s_now_ms;
+static uint64_t s_seq = 0;
+static size_t s_heap_used = 0;
+static bool s_trace = false;
+static bool s_log = false;
+static void (*s_event_loop)(void) = NULL;
+
+static CallSite s_calls[MAX_CALL_SITES];
+static int s_call_count = 0;
+
+static Window *s_window = NULL;
+static bool s_dirty = false;
+static bool s_drawing = false;
+static struct GContext s_ctx;
+
+static AppTimer **s_timers = NULL;
+static size_t s_timer_count = 0;
+static size_t s_timer_capacity = 0;
+
+static PropertyAnimation **s_animations = NULL;
+static size_t s_animation_count = 0;
+static size_t s_animation_capacity = 0;
+static int64_t s_animation_next_ms = -1;
+
+static SimEvent *s_events = NULL;
+static size_t s_event_count = 0;
+static size_t s_event_capacity = 0;
+
+static TickHandler s_tick_handler = NULL;
+static TimeUnits s_tick_units = 0;
+static int64_t s_next_tick_ms = -1;
+
+static BatteryChargeState s_battery = { .charge_percent = 80 };
+static BatteryStateHandler s_battery_handler = NULL;
+static bool s_connected = true;
+static ConnectionHandlers s_connection_handlers;
+static AccelTapHandler s_tap_handler = NULL;
+
+static ClickHandler s_single_click[NUM_BUTTONS];
+static ClickHandler s_long_click[NUM_BUTTONS];
+
+static PersistEntry s_persist[MAX_PERSIST_KEYS];
+static int s_persist_count = 0;
+
+static AppMessageInboxReceived s_inbox_received = NULL;
+static AppMessageInboxDropped s_inbox_dropped = NULL;
+static AppMessageOutboxSent s_outbox_sent = NULL;
+static AppMessageOutboxFailed s_outbox_failed = NULL;
+static uint32_t s_inbox_size = 0;
+static uint8_t *s_outbox = NULL;
+static uint32_t s_outbox_size = 0;
+static DictionaryIterator s_outbox_iter;
+static bool s_outbox_building = false;
+static bool s_outbox_sending = false;
+static SimSendHandler s_send_handler = NULL;
+static AppSync *s_sync = NULL;
+
+static bool s_worker_running = false;
+
+static const struct SimFont FONTS[] = {
+  { FONT_KEY_GOTHIC_14, 6, 14 },
+  { FONT_KEY_GOTHIC_18, 8, 18 },
+  { FONT_KEY_GOTHIC_18_BOLD, 9, 18 },
+  { FONT_KEY_BITHAM_42_BOLD, 24, 42 },
+  { FONT_KEY_BITHAM_42_LIGHT, 20, 42 },
+};
+
+// Bookkeeping
+
+static void sim_error(const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+  fprintf(stderr, "sim: error at +%lld ms: ", (long long)(s_now_ms - s_start_ms));
+  vfprintf(stderr, format, args);
+  fputc('\n', stderr);
+  va_end(args);
+  s_report.api_errors++;
+}
+
+static void record_call(const char *name) {
+  if (s_trace) {
+    printf("%10lld ms  %s\n", (long long)(s_now_ms - s_start_ms), name);
+  }
+  for (int i = 0; i < s_call_count; i++) {
+    if (s_calls[i].name == name) {
+      s_calls[i].count++;
+      return;
+    }
+  }
+  if (s_call_count < MAX_CALL_SITES) {
+    s_calls[s_call_count++] = (CallSite) { .name = name, .count = 1 };
+  }
+}
+#define RECORD_CALL() record_call(__func__)
+
+static void *grow(void *array, size_t *capacity, size_t element_size) {
+  *capacity = *capacity ? *capacity * 2 : 16;
+  array = realloc(array, *capacity * element_size);
+  if (!array) {
+    fprintf(stderr, "sim: out of memory\n");
+    exit(2);
+  }
+  return array;
+}
+
+static void *object_create(SimKind kind, size_t size) {
+  SimObject *object = calloc(1, size);
+  if (!object) {
+    fprintf(stderr, "sim: out of memory\n");
+    exit(2);
+  }
+  object->kind = kind;
+  object->alive = true;
+  object->size = size;
+
+  s_report.allocations[kind]++;
+  s_report.live[kind]++;
+  s_heap_used += size;
+  if (s_heap_used > s_report.heap_peak) {
+    s_report.heap_peak = s_heap_used;
+  }
+  return object;
+}
+
+static void object_destroy(SimObject *object) {
+  object->alive = false;
+  s_report.frees[object->kind]++;
+  s_report.live[object->kind]--;
+  s_heap_used -= object->size;
+}
+
+// Whether a handle may be used; reports the call otherwise
+static bool check_live(const void *handle, SimKind kind, const char *call) {
+  const SimObject *object = handle;
+  if (!object) {
+    sim_error("%s on NULL", call);
+    return false;
+  }
+  const bool kind_ok = object->kind == kind || (kind == SIM_LAYER && object->kind == SIM_TEXT_LAYER);
+  if (!kind_ok) {
+    sim_error("%s on one of the %s instead of %s", call, SIM_KIND_NAMES[object->kind], SIM_KIND_NAMES[kind]);
+    return false;
+  }
+  if (!object->alive) {
+    sim_error("%s on one of the destroyed %s", call, SIM_KIND_NAMES[kind]);
+    return false;
+  }
+  return true;
+}
+
+static void schedule_event(uint32_t delay_ms, SimEventHandler handler, void *data, uint32_t size) {
+  if (s_event_count == s_event_capacity) {
+    s_events = grow(s_events, &s_event_capacity, sizeof(*s_events));
+  }
+  s_events[s_event_count++] = (SimEvent) {
+    .due_ms = s_now_ms + delay_ms, .seq = ++s_seq, .handler = handler, .data = data, .size = size
+  };
+}
+
+// Rendering: like the firmware, any dirty layer redraws the whole window
+
+static void mark_dirty(void) {
+  s_dirty = true;
+}
+
+static void draw_layer(Layer *layer) {
+  if (layer->hidden) {
+    return;
+  }
+  if (layer->object.kind == SIM_TEXT_LAYER) {
+    TextLayer *text_layer = (TextLayer *)layer;
+    if (text_layer->text) {
+      s_report.text_draws++;
+    }
+  } else if (layer->update_proc) {
+    s_report.layer_draws++;
+    layer->update_proc(layer, &s_ctx);
+  }
+  for (Layer *child = layer->first_child; child; child = child->next_sibling) {
+    draw_layer(child);
+  }
+}
+
+static void render(void) {
+  if (!s_dirty || !s_window || !s_window->loaded) {
+    return;
+  }
+  s_dirty = false;
+  s_report.frames++;
+  s_drawing = true;
+  draw_layer(&s_window->root);
+  s_drawing = false;
+}
+
+static void detach_layer(Layer *layer) {
+  Layer *parent = layer->parent;
+  if (!parent) {
+    return;
+  }
+  for (Layer **link = &parent->first_child; *link; link = &(*link)->next_sibling) {
+    if (*link == layer) {
+      *link = layer->next_sibling;
+      break;
+    }
+  }
+  layer->parent = NULL;
+  layer->next_sibling = NULL;
+  mark_dirty();
+}
+
+static void layer_init(Layer *layer, GRect frame) {
+  layer->frame = frame;
+  layer->clips = true;
+}
+
+static void layer_deinit(Layer *layer) {
+  detach_layer(layer);
+  // Children stay alive but leave the tree, as on the watch
+  while (layer->first_child) {
+    detach_layer(layer->first_child);
+  }
+}
+
+// Virtual clock
+
+time_t sim_time(time_t *tloc) {
+  const time_t now = (time_t)(s_now_ms / 1000);
+  if (tloc) {
+    *tloc = now;
+  }
+  return now;
+}
+
+uint16_t time_ms(time_t *t_utc, uint16_t *out_ms) {
+  RECORD_CALL();
+  const uint16_t ms = (uint16_t)(s_now_ms % 1000);
+  if (t_utc) {
+    *t_utc = (time_t)(s_now_ms / 1000);
+  }
+  if (out_ms) {
+    *out_ms = ms;
+  }
+  return ms;
+}
+
+bool clock_is_24h_style(void) {
+  RECORD_CALL();
+  return true;
+}
+
+static int64_t next_tick_after(int64_t ms) {
+  const int64_t unit = (s_tick_units & SECOND_UNIT) ? 1000 : 60 * 1000;
+  return (ms / unit + 1) * unit;
+}
+
+// Logging
+
+void app_log(uint8_t log_level, const char *src_filename, int src_line_number, const char *fmt, ...) {
+  if (!s_log) {
+    return;
+  }
+  const char *file = strrchr(src_filename, '/');
+  printf("%10lld ms  [%u] %s:%d ", (long long)(s_now_ms - s_start_ms), log_level,
+         file ? file + 1 : src_filename, src_line_number);
+  va_list args;
+  va_start(args, fmt);
+  vprintf(fmt, args);
+  va_end(args);
+  putchar('\n');
+}
+
+// Graphics
+
+bool gcolor_equal(GColor8 x, GColor8 y) {
+  return x.argb == y.argb;
+}
+
+GFont fonts_get_system_font(const char *font_key) {
+  RECORD_CALL();
+  for (size_t i = 0; i < ARRAY_LENGTH(FONTS); i++) {
+    if (strcmp(FONTS[i].key, font_key) == 0) {
+      return (GFont)&FONTS[i];
+    }
+  }
+  sim_error("fonts_get_system_font: unknown font %s", font_key);
+  return (GFont)&FONTS[0];
+}
+
+static void graphics_call(const char *call) {
+  record_call(call);
+  s_report.graphics_calls++;
+  if (!s_drawing) {
+    sim_error("%s outside of an update proc", call);
+  }
+}
+
+void graphics_context_set_stroke_color(GContext *ctx, GColor color) {
+  graphics_call(__func__);
+  ctx->stroke_color = color;
+}
+
+void graphics_context_set_fill_color(GContext *ctx, GColor color) {
+  graphics_call(__func__);
+  ctx->fill_color = color;
+}
+
+void graphics_context_set_text_color(GContext *ctx, GColor color) {
+  graphics_call(__func__);
+  ctx->text_color = color;
+}
+
+void graphics_fill_rect(GContext *ctx, GRect rect, uint16_t corner_radius, GCornerMask corner_mask) {
+  graphics_call(__func__);
+}
+
+void graphics_draw_rect(GContext *ctx, GRect rect) {
+  graphics_call(__func__);
+}
+
+void graphics_draw_line(GContext *ctx, GPoint p0, GPoint p1) {
+  graphics_call(__func__);
+}
+
+void graphics_draw_text(GContext *ctx, const char *text, GFont const font, const GRect box,
+                        const GTextOverflowMode overflow_mode, const GTextAlignment alignment,
+                        GTextAttributes *text_attributes) {
+  graphics_call(__func__);
+}
+
+// Single line, UTF-8 characters at the font's average advance, spaces at half
+GSize graphics_text_layout_get_content_size(const char *text, GFont const font, const GRect box,
+                                            const GTextOverflowMode overflow_mode,
+                                            const GTextAlignment alignment) {
+  RECORD_CALL();
+  int width = 0;
+  for (const char *c = text; c && *c; c++) {
+    if (*c == ' ') {
+      width += font->char_width / 2;
+    } else if ((*c & 0xC0) != 0x80) {
+      width += font->char_width;
+    }
+  }
+  if (width > box.size.w) {
+    width = box.size.w;
+  }
+  return GSize(width, width > 0 ? font->height : 0);
+}
+
+// Layers
+
+Layer *layer_create(GRect frame) {
+  RECORD_CALL();
+  Layer *layer = object_create(SIM_LAYER, sizeof(Layer));
+  layer_init(layer, frame);
+  return layer;
+}
+
+void layer_destroy(Layer *layer) {
+  RECORD_CALL();
+  if (!check_live(layer, SIM_LAYER, __func__)) return;
+  if (layer->object.kind != SIM_LAYER) {
+    sim_error("layer_destroy on a text layer");
+    return;
+  }
+  layer_deinit(layer);
+  object_destroy(&layer->object);
+}
+
+void layer_mark_dirty(Layer *layer) {
+  RECORD_CALL();
+  if (!check_live(layer, SIM_LAYER, __func__)) return;
+  mark_dirty();
+}
+
+void layer_set_update_proc(Layer *layer, LayerUpdateProc update_proc) {
+  RECORD_CALL();
+  if (!check_live(layer, SIM_LAYER, __func__)) return;
+  layer->update_proc = update_proc;
+}
+
+void layer_set_frame(Layer *layer, GRect frame) {
+  RECORD_CALL();
+  if (!check_live(layer, SIM_LAYER, __func__)) return;
+  if (memcmp(&layer->frame, &frame, sizeof(frame)) != 0) {
+    layer->frame = frame;
+    mark_dirty();
+  }
+}
+
+GRect layer_get_frame(const Layer *layer) {
+  RECORD_CALL();
+  if (!check_live(layer, SIM_LAYER, __func__)) return GRectZero;
+  return layer->frame;
+}
+
+GRect layer_get_bounds(const Layer *layer) {
+  RECORD_CALL();
+  if (!check_live(layer, SIM_LAYER, __func__)) return GRectZero;
+  return GRect(0, 0, layer->frame.size.w, layer->frame.size.h);
+}
+
+void layer_add_child(Layer *parent, Layer *child) {
+  RECORD_CALL();
+  if (!check_live(parent, SIM_LAYER, __func__) || !check_live(child, SIM_LAYER, __func__)) return;
+  detach_layer(child);
+  Layer **link = &parent->first_child;
+  while (*link) {
+    link = &(*link)->next_sibling;
+  }
+  *link = child;
+  child->parent = parent;
+  mark_dirty();
+}
+
+void layer_remove_from_parent(Layer *child) {
+  RECORD_CALL();
+  if (!check_live(child, SIM_LAYER, __func__)) return;
+  detach_layer(child);
+}
+
+void layer_set_hidden(Layer *layer, bool hidden) {
+  RECORD_CALL();
+  if (!check_live(layer, SIM_LAYER, __func__)) return;
+  if (layer->hidden != hidden) {
+    layer->hidden = hidden;
+    mark_dirty();
+  }
+}
+
+bool layer_get_hidden(const Layer *layer) {
+  RECORD_CALL();
+  if (!check_live(layer, SIM_LAYER, __func__)) return false;
+  return layer->hidden;
+}
+
+void layer_set_clips(Layer *layer, bool clips) {
+  RECORD_CALL();
+  if (!check_live(layer, SIM_LAYER, __func__)) return;
+  layer->clips = clips;
+}
+
+TextLayer *text_layer_create(GRect frame) {
+  RECORD_CALL();
+  TextLayer *text_layer = object_create(SIM_TEXT_LAYER, sizeof(TextLayer));
+  layer_init(&text_layer->layer, frame);
+  text_layer->font = (GFont)&FONTS[0];
+  text_layer->text_color = GColorBlack;
+  text_layer->background_color = GColorWhite;
+  return text_layer;
+}
+
+void text_layer_destroy(TextLayer *text_layer) {
+  RECORD_CALL();
+  if (!check_live(text_layer, SIM_TEXT_LAYER, __func__)) return;
+  layer_deinit(&text_layer->layer);
+  object_destroy(&text_layer->layer.object);
+}
+
+Layer *text_layer_get_layer(TextLayer *text_layer) {
+  RECORD_CALL();
+  if (!check_live(text_layer, SIM_TEXT_LAYER, __func__)) return NULL;
+  return &text_layer->layer;
+}
+
+void text_layer_set_text(TextLayer *text_layer, const char *text) {
+  RECORD_CALL();
+  if (!check_live(text_layer, SIM_TEXT_LAYER, __func__)) return;
+  text_layer->text = text;
+  mark_dirty();
+}
+
+const char *text_layer_get_text(TextLayer *text_layer) {
+  RECORD_CALL();
+  if (!check_live(text_layer, SIM_TEXT_LAYER, __func__)) return NULL;
+  return text_layer->text;
+}
+
+void text_layer_set_background_color(TextLayer *text_layer, GColor color) {
+  RECORD_CALL();
+  if (!check_live(text_layer, SIM_TEXT_LAYER, __func__)) return;
+  text_layer->background_color = color;
+  mark_dirty();
+}
+
+void text_layer_set_text_color(TextLayer *text_layer, GColor color) {
+  RECORD_CALL();
+  if (!check_live(text_layer, SIM_TEXT_LAYER, __func__)) return;
+  text_layer->text_color = color;
+  mark_dirty();
+}
+
+void text_layer_set_text_alignment(TextLayer *text_layer, GTextAlignment text_alignment) {
+  RECORD_CALL();
+  if (!check_live(text_layer, SIM_TEXT_LAYER, __func__)) return;
+  text_layer->alignment = text_alignment;
+  mark_dirty();
+}
+
+void text_layer_set_font(TextLayer *text_layer, GFont font) {
+  RECORD_CALL();
+  if (!check_live(text_layer, SIM_TEXT_LAYER, __func__)) return;
+  text_layer->font = font;
+  mark_dirty();
+}
+
+// Windows and buttons
+
+Window *window_create(void) {
+  RECORD_CALL();
+  Window *window = object_create(SIM_WINDOW, sizeof(Window));
+  window->root.object = (SimObject) { .kind = SIM_LAYER, .alive = true };
+  layer_init(&window->root, GRect(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT));
+  return window;
+}
+
+void window_destroy(Window *window) {
+  RECORD_CALL();
+  if (!check_live(window, SIM_WINDOW, __func__)) return;
+  if (window == s_window) {
+    if (window->handlers.disappear) {
+      window->handlers.disappear(window);
+    }
+    if (window->handlers.unload) {
+      window->handlers.unload(window);
+    }
+    window->loaded = false;
+    s_window = NULL;
+  }
+  layer_deinit(&window->root);
+  window->root.object.alive = false;
+  object_destroy(&window->object);
+}
+
+void window_set_window_handlers(Window *window, WindowHandlers handlers) {
+  RECORD_CALL();
+  if (!check_live(window, SIM_WINDOW, __func__)) return;
+  window->handlers = handlers;
+}
+
+void window_set_background_color(Window *window, GColor background_color) {
+  RECORD_CALL();
+  if (!check_live(window, SIM_WINDOW, __func__)) return;
+  window->background_color = background_color;
+  mark_dirty();
+}
+
+Layer *window_get_root_layer(const Window *window) {
+  RECORD_CALL();
+  if (!check_live(window, SIM_WINDOW, __func__)) return NULL;
+  return (Layer *)&window->root;
+}
+
+// A single window stack entry is all a watchface needs
+void window_stack_push(Window *window, bool animated) {
+  RECORD_CALL();
+  if (!check_live(window, SIM_WINDOW, __func__)) return;
+  if (s_window) {
+    sim_error("window_stack_push: a window is on the stack already");
+    return;
+  }
+  s_window = window;
+  if (window->handlers.load) {
+    window->handlers.load(window);
+  }
+  window->loaded = true;
+  if (window->handlers.appear) {
+    window->handlers.appear(window);
+  }
+  mark_dirty();
+  render();
+}
+
+void window_set_click_config_provider(Window *window, ClickConfigProvider click_config_provider) {
+  RECORD_CALL();
+  if (!check_live(window, SIM_WINDOW, __func__)) return;
+  memset(s_single_click, 0, sizeof(s_single_click));
+  memset(s_long_click, 0, sizeof(s_long_click));
+  if (click_config_provider) {
+    click_config_provider(window);
+  }
+}
+
+void window_single_click_subscribe(ButtonId button_id, ClickHandler handler) {
+  RECORD_CALL();
+  s_single_click[button_id] = handler;
+}
+
+void window_single_repeating_click_subscribe(ButtonId button_id, uint16_t repeat_interval_ms, ClickHandler handler) {
+  RECORD_CALL();
+  s_single_click[button_id] = handler;
+}
+
+void window_long_click_subscribe(ButtonId button_id, uint16_t delay_ms, ClickHandler down_handler, ClickHandler up_handler) {
+  RECORD_CALL();
+  s_long_click[button_id] = down_handler;
+}
+
+// Animations
+
+static void remove_animation(PropertyAnimation *property_animation) {
+  for (size_t i = 0; i < s_animation_count; i++) {
+    if (s_animations[i] == property_animation) {
+      memmove(&s_animations[i], &s_animations[i + 1], (s_animation_count - i - 1) * sizeof(*s_animations));
+      s_animation_count--;
+      return;
+    }
+  }
+}
+
+// The stopped handler runs first, then the animation is gone (SDK 3)
+static void stop_animation(PropertyAnimation *property_animation, bool finished) {
+  Animation *animation = &property_animation->animation;
+  animation->scheduled = false;
+  remove_animation(property_animation);
+  if (finished) {
+    s_report.animations_finished++;
+  } else {
+    s_report.animations_cancelled++;
+  }
+  if (animation->handlers.stopped) {
+    animation->handlers.stopped(animation, finished, animation->context);
+  }
+  if (animation->object.alive) {
+    object_destroy(&animation->object);
+  }
+}
+
+static void set_animated_frame(PropertyAnimation *property_animation, GRect frame) {
+  Layer *layer = property_animation->layer;
+  if (!layer->object.alive) {
+    sim_error("property animation moves one of the destroyed %s", SIM_KIND_NAMES[layer->object.kind]);
+    return;
+  }
+  if (memcmp(&layer->frame, &frame, sizeof(frame)) != 0) {
+    layer->frame = frame;
+    mark_dirty();
+  }
+}
+
+static int16_t interpolate(int16_t from, int16_t to, int64_t elapsed, uint32_t duration) {
+  return (int16_t)(from + (to - from) * elapsed / duration);
+}
+
+static void animation_frame(void) {
+  // Handlers may schedule or unschedule animations; work on a copy
+  const size_t count = s_animation_count;
+  PropertyAnimation **animations = malloc(count * sizeof(*animations));
+  memcpy(animations, s_animations, count * sizeof(*animations));
+
+  for (size_t i = 0; i < count; i++) {
+    PropertyAnimation *property_animation = animations[i];
+    Animation *animation = &property_animation->animation;
+    if (!animation->object.alive || !animation->scheduled || s_now_ms < animation->start_ms) {
+      continue;
+    }
+    if (!animation->started) {
+      animation->started = true;
+      if (!property_animation->has_from) {
+        property_animation->from = property_animation->layer->frame;
+      }
+      if (animation->handlers.started) {
+        animation->handlers.started(animation, animation->context);
+      }
+    }
+    const int64_t elapsed = s_now_ms - animation->start_ms;
+    if (elapsed >= animation->duration_ms) {
+      set_animated_frame(property_animation, property_animation->to);
+      stop_animation(property_animation, true);
+      continue;
+    }
+    const GRect from = property_animation->from;
+    const GRect to = property_animation->to;
+    set_animated_frame(property_animation, GRect(
+      interpolate(from.origin.x, to.origin.x, elapsed, animation->duration_ms),
+      interpolate(from.origin.y, to.origin.y, elapsed, animation->duration_ms),
+      interpolate(from.size.w, to.size.w, elapsed, animation->duration_ms),
+      interpolate(from.size.h, to.size.h, elapsed, animation->duration_ms)));
+  }
+  free(animations);
+
+  s_animation_next_ms = s_animation_count > 0 ? s_now_ms + ANIMATION_FRAME_MS : -1;
+}
+
+PropertyAnimation *property_animation_create_layer_frame(Layer *layer, GRect *from_frame, GRect *to_frame) {
+  RECORD_CALL();
+  if (!check_live(layer, SIM_LAYER, __func__)) return NULL;
+  PropertyAnimation *property_animation = object_create(SIM_PROPERTY_ANIMATION, sizeof(PropertyAnimation));
+  property_animation->animation.duration_ms = 250;
+  property_animation->layer = layer;
+  property_animation->has_from = from_frame != NULL;
+  property_animation->from = from_frame ? *from_frame : layer->frame;
+  property_animation->to = to_frame ? *to_frame : layer->frame;
+  return property_animation;
+}
+
+void property_animation_destroy(PropertyAnimation *property_animation) {
+  RECORD_CALL();
+  if (!check_live(property_animation, SIM_PROPERTY_ANIMATION, __func__)) return;
+  if (property_animation->animation.scheduled) {
+    stop_animation(property_animation, false);
+  } else {
+    object_destroy(&property_animation->animation.object);
+  }
+}
+
+Animation *property_animation_get_animation(PropertyAnimation *property_animation) {
+  RECORD_CALL();
+  if (!check_live(property_animation, SIM_PROPERTY_ANIMATION, __func__)) return NULL;
+  return &property_animation->animation;
+}
+
+bool animation_set_duration(Animation *animation, uint32_t duration_ms) {
+  RECORD_CALL();
+  if (!check_live(animation, SIM_PROPERTY_ANIMATION, __func__)) return false;
+  animation->duration_ms = duration_ms ? duration_ms : 1;
+  return true;
+}
+
+bool animation_set_delay(Animation *animation, uint32_t delay_ms) {
+  RECORD_CALL();
+  if (!check_live(animation, SIM_PROPERTY_ANIMATION, __func__)) return false;
+  animation->delay_ms = delay_ms;
+  return true;
+}
+
+bool animation_set_curve(Animation *animation, AnimationCurve curve) {
+  RECORD_CALL();
+  if (!check_live(animation, SIM_PROPERTY_ANIMATION, __func__)) return false;
+  animation->curve = curve;
+  return true;
+}
+
+bool animation_set_handlers(Animation *animation, AnimationHandlers callbacks, void *context) {
+  RECORD_CALL();
+  if (!check_live(animation, SIM_PROPERTY_ANIMATION, __func__)) return false;
+  animation->handlers = callbacks;
+  animation->context = context;
+  return true;
+}
+
+bool animation_schedule(Animation *animation) {
+  RECORD_CALL();
+  if (!check_live(animation, SIM_PROPERTY_ANIMATION, __func__)) return false;
+  if (animation->scheduled) {
+    return true;
+  }
+  animation->scheduled = true;
+  animation->started = false;
+  animation->start_ms = s_now_ms + animation->delay_ms;
+  if (s_animation_count == s_animation_capacity) {
+    s_animations = grow(s_animations, &s_animation_capacity, sizeof(*s_animations));
+  }
+  s_animations[s_animation_count++] = (PropertyAnimation *)animation;
+  s_report.animations_scheduled++;
+  if (s_animation_next_ms < 0) {
+    s_animation_next_ms = s_now_ms + ANIMATION_FRAME_MS;
+  }
+  return true;
+}
+
+bool animation_unschedule(Animation *animation) {
+  RECORD_CALL();
+  if (!check_live(animation, SIM_PROPERTY_ANIMATION, __func__)) return false;
+  if (!animation->scheduled) {
+    return false;
+  }
+  stop_animation((PropertyAnimation *)animation, false);
+  return true;
+}
+
+void animation_unschedule_all(void) {
+  RECORD_CALL();
+  while (s_animation_count > 0) {
+    stop_animation(s_animations[0], false);
+  }
+}
+
+bool animation_is_scheduled(Animation *animation) {
+  RECORD_CALL();
+  if (!check_live(animation, SIM_PROPERTY_ANIMATION, __func__)) return false;
+  return animation->scheduled;
+}
+
+bool animation_destroy(Animation *animation) {
+  RECORD_CALL();
+  if (!check_live(animation, SIM_PROPERTY_ANIMATION, __func__)) return false;
+  property_animation_destroy((PropertyAnimation *)animation);
+  return true;
+}
+
+// Timers
+
+static void remove_timer(AppTimer *timer) {
+  for (size_t i = 0; i < s_timer_count; i++) {
+    if (s_timers[i] == timer) {
+      s_timers[i] = s_timers[--s_timer_count];
+      return;
+    }
+  }
+}
+
+AppTimer *app_timer_register(uint32_t timeout_ms, AppTimerCallback callback, void *callback_data) {
+  RECORD_CALL();
+  AppTimer *timer = object_create(SIM_APP_TIMER, sizeof(AppTimer));
+  timer->due_ms = s_now_ms + timeout_ms;
+  timer->seq = ++s_seq;
+  timer->callback = callback;
+  timer->data = callback_data;
+  if (s_timer_count == s_timer_capacity) {
+    s_timers = grow(s_timers, &s_timer_capacity, sizeof(*s_timers));
+  }
+  s_timers[s_timer_count++] = timer;
+  return timer;
+}
+
+// A timer that already fired is gone: false, like on the watch
+bool app_timer_reschedule(AppTimer *timer_handle, uint32_t new_timeout_ms) {
+  RECORD_CALL();
+  if (!timer_handle || !timer_handle->object.alive) {
+    return false;
+  }
+  timer_handle->due_ms = s_now_ms + new_timeout_ms;
+  timer_handle->seq = ++s_seq;
+  return true;
+}
+
+// Cancelling a timer that fired may cancel an unrelated one on the watch
+void app_timer_cancel(AppTimer *timer_handle) {
+  RECORD_CALL();
+  if (!check_live(timer_handle, SIM_APP_TIMER, __func__)) return;
+  remove_timer(timer_handle);
+  object_destroy(&timer_handle->object);
+}
+
+static void fire_timer(AppTimer *timer) {
+  remove_timer(timer);
+  object_destroy(&timer->object);
+  s_report.timer_wakeups++;
+  timer->callback(timer->data);
+}
+
+// Services
+
+void tick_timer_service_subscribe(TimeUnits tick_units, TickHandler handler) {
+  RECORD_CALL();
+  s_tick_units = tick_units;
+  s_tick_handler = handler;
+  s_next_tick_ms = next_tick_after(s_now_ms);
+}
+
+void tick_timer_service_unsubscribe(void) {
+  RECORD_CALL();
+  s_tick_handler = NULL;
+  s_next_tick_ms = -1;
+}
+
+static void fire_tick(void) {
+  const time_t now = (time_t)(s_now_ms / 1000);
+  struct tm tick_time = *localtime(&now);
+  TimeUnits changed = SECOND_UNIT;
+  if (tick_time.tm_sec == 0) {
+    changed |= MINUTE_UNIT;
+    if (tick_time.tm_min == 0) {
+      changed |= HOUR_UNIT;
+      if (tick_time.tm_hour == 0) {
+        changed |= DAY_UNIT;
+        if (tick_time.tm_mday == 1) {
+          changed |= MONTH_UNIT;
+          if (tick_time.tm_mon == 0) {
+            changed |= YEAR_UNIT;
+          }
+        }
+      }
+    }
+  }
+  s_next_tick_ms = next_tick_after(s_now_ms);
+  if (changed & s_tick_units) {
+    s_report.ticks++;
+    s_tick_handler(&tick_time, changed);
+  }
+}
+
+BatteryChargeState battery_state_service_peek(void) {
+  RECORD_CALL();
+  return s_battery;
+}
+
+void battery_state_service_subscribe(BatteryStateHandler handler) {
+  RECORD_CALL();
+  s_battery_handler = handler;
+}
+
+void battery_state_service_unsubscribe(void) {
+  RECORD_CALL();
+  s_battery_handler = NULL;
+}
+
+bool connection_service_peek_pebble_app_connection(void) {
+  RECORD_CALL();
+  return s_connected;
+}
+
+void connection_service_subscribe(ConnectionHandlers conn_handlers) {
+  RECORD_CALL();
+  s_connection_handlers = conn_handlers;
+}
+
+void connection_service_unsubscribe(void) {
+  RECORD_CALL();
+  memset(&s_connection_handlers, 0, sizeof(s_connection_handlers));
+}
+
+int accel_service_set_sampling_rate(AccelSamplingRate rate) {
+  RECORD_CALL();
+  return 0;
+}
+
+void accel_tap_service_subscribe(AccelTapHandler handler) {
+  RECORD_CALL();
+  s_tap_handler = handler;
+}
+
+void accel_tap_service_unsubscribe(void) {
+  RECORD_CALL();
+  s_tap_handler = NULL;
+}
+
+// Memory
+
+size_t heap_bytes_used(void) {
+  RECORD_CALL();
+  return s_heap_used;
+}
+
+size_t heap_bytes_free(void) {
+  RECORD_CALL();
+  return s_heap_used < SIM_HEAP_SIZE ? SIM_HEAP_SIZE - s_heap_used : 0;
+}
+
+// Persistent storage, kept in memory for the run
+
+static PersistEntry *persist_find(uint32_t key) {
+  for (int i = 0; i < s_persist_count; i++) {
+    if (s_persist[i].key == key) {
+      return &s_persist[i];
+    }
+  }
+  return NULL;
+}
+
+static int persist_store(uint32_t key, const void *data, size_t size) {
+  if (size > PERSIST_DATA_MAX_LENGTH) {
+    size = PERSIST_DATA_MAX_LENGTH;
+  }
+  PersistEntry *entry = persist_find(key);
+  if (!entry) {
+    if (s_persist_count == MAX_PERSIST_KEYS) {
+      sim_error("persistent storage full");
+      return 0;
+    }
+    entry = &s_persist[s_persist_count++];
+    entry->key = key;
+  }
+  entry->length = (uint16_t)size;
+  memcpy(entry->data, data, size);
+  s_report.persist_writes++;
+  s_report.persist_bytes_written += size;
+  return (int)size;
+}
+
+bool persist_exists(const uint32_t key) {
+  RECORD_CALL();
+  return persist_find(key) != NULL;
+}
+
+int32_t persist_read_int(const uint32_t key) {
+  RECORD_CALL();
+  const PersistEntry *entry = persist_find(key);
+  int32_t value = 0;
+  if (entry) {
+    memcpy(&value, entry->data, entry->length < sizeof(value) ? entry->length : sizeof(value));
+  }
+  return value;
+}
+
+bool persist_read_bool(const uint32_t key) {
+  RECORD_CALL();
+  const PersistEntry *entry = persist_find(key);
+  return entry && entry->length > 0 && entry->data[0];
+}
+
+int persist_read_data(const uint32_t key, void *buffer, const size_t buffer_size) {
+  RECORD_CALL();
+  const PersistEntry *entry = persist_find(key);
+  if (!entry) {
+    return E_DOES_NOT_EXIST;
+  }
+  const size_t length = entry->length < buffer_size ? entry->length : buffer_size;
+  memcpy(buffer, entry->data, length);
+  return (int)length;
+}
+
+status_t persist_write_int(const uint32_t key, const int32_t value) {
+  RECORD_CALL();
+  persist_store(key, &value, sizeof(value));
+  return S_SUCCESS;
+}
+
+status_t persist_write_bool(const uint32_t key, const bool value) {
+  RECORD_CALL();
+  const uint8_t byte = value ? 1 : 0;
+  persist_store(key, &byte, sizeof(byte));
+  return S_SUCCESS;
+}
+
+int persist_write_data(const uint32_t key, const void *data, const size_t size) {
+  RECORD_CALL();
+  return persist_store(key, data, size);
+}
+
+status_t persist_delete(const uint32_t key) {
+  RECORD_CALL();
+  PersistEntry *entry = persist_find(key);
+  if (!entry) {
+    return E_DOES_NOT_EXIST;
+  }
+  *entry = s_persist[--s_persist_count];
+  return S_SUCCESS;
+}
+
+// Dictionaries
+
+#define TUPLE_HEADER_SIZE 7
+
+static Tuple *next_tuple(const Tuple *tuple) {
+  return (Tuple *)((const uint8_t *)tuple + TUPLE_HEADER_SIZE + tuple->length);
+}
+
+static DictionaryResult write_tuple(DictionaryIterator *iter, uint32_t key, TupleType type,
+                                    const void *data, uint16_t length) {
+  if (!iter || !iter->dictionary || !iter->cursor) {
+    return DICT_INVALID_ARGS;
+  }
+  uint8_t *cursor = (uint8_t *)iter->cursor;
+  if (cursor + TUPLE_HEADER_SIZE + length > (const uint8_t *)iter->end) {
+    return DICT_NOT_ENOUGH_STORAGE;
+  }
+  iter->cursor->key = key;
+  iter->cursor->type = type;
+  iter->cursor->length = length;
+  memcpy(cursor + TUPLE_HEADER_SIZE, data, length);
+  iter->cursor = next_tuple(iter->cursor);
+  iter->dictionary->count++;
+  return DICT_OK;
+}
+
+DictionaryResult dict_write_begin(DictionaryIterator *iter, uint8_t *const buffer, const uint16_t size) {
+  RECORD_CALL();
+  if (!iter || !buffer || size < 1) {
+    return DICT_INVALID_ARGS;
+  }
+  iter->dictionary = (Dictionary *)buffer;
+  iter->dictionary->count = 0;
+  iter->cursor = iter->dictionary->head;
+  iter->end = buffer + size;
+  return DICT_OK;
+}
+
+DictionaryResult dict_write_data(DictionaryIterator *iter, const uint32_t key, const uint8_t *const data, const uint16_t size) {
+  RECORD_CALL();
+  return write_tuple(iter, key, TUPLE_BYTE_ARRAY, data, size);
+}
+
+DictionaryResult dict_write_cstring(DictionaryIterator *iter, const uint32_t key, const char *const cstring) {
+  RECORD_CALL();
+  return write_tuple(iter, key, TUPLE_CSTRING, cstring, (uint16_t)(strlen(cstring) + 1));
+}
+
+DictionaryResult dict_write_uint8(DictionaryIterator *iter, const uint32_t key, const uint8_t value) {
+  RECORD_CALL();
+  return write_tuple(iter, key, TUPLE_UINT, &value, sizeof(value));
+}
+
+DictionaryResult dict_write_uint16(DictionaryIterator *iter, const uint32_t key, const uint16_t value) {
+  RECORD_CALL();
+  return write_tuple(iter, key, TUPLE_UINT, &value, sizeof(value));
+}
+
+DictionaryResult dict_write_uint32(DictionaryIterator *iter, const uint32_t key, const uint32_t value) {
+  RECORD_CALL();
+  return write_tuple(iter, key, TUPLE_UINT, &value, sizeof(value));
+}
+
+DictionaryResult dict_write_int32(DictionaryIterator *iter, const uint32_t key, const int32_t value) {
+  RECORD_CALL();
+  return write_tuple(iter, key, TUPLE_INT, &value, sizeof(value));
+}
+
+DictionaryResult dict_write_tuplet(DictionaryIterator *iter, const Tuplet *const tuplet) {
+  RECORD_CALL();
+  switch (tuplet->type) {
+    case TUPLE_BYTE_ARRAY:
+      return write_tuple(iter, tuplet->key, tuplet->type, tuplet->bytes.data, tuplet->bytes.length);
+    case TUPLE_CSTRING:
+      return write_tuple(iter, tuplet->key, tuplet->type, tuplet->cstring.data, tuplet->cstring.length);
+    default:
+      // Little endian, so the low bytes of the storage are the value
+      return write_tuple(iter, tuplet->key, tuplet->type, &tuplet->integer.storage, tuplet->integer.width);
+  }
+}
+
+uint32_t dict_write_end(DictionaryIterator *iter) {
+  RECORD_CALL();
+  if (!iter || !iter->dictionary || !iter->cursor) {
+    return 0;
+  }
+  iter->end = iter->cursor;
+  return (uint32_t)((uint8_t *)iter->end - (uint8_t *)iter->dictionary);
+}
+
+uint32_t dict_size(DictionaryIterator *iter) {
+  RECORD_CALL();
+  return (uint32_t)((const uint8_t *)iter->end - (const uint8_t *)iter->dictionary);
+}
+
+Tuple *dict_read_begin_from_buffer(DictionaryIterator *iter, const uint8_t *const buffer, const uint16_t size) {
+  RECORD_CALL();
+  iter->dictionary = (Dictionary *)buffer;
+  iter->end = buffer + size;
+  return dict_read_first(iter);
+}
+
+Tuple *dict_read_first(DictionaryIterator *iter) {
+  RECORD_CALL();
+  iter->cursor = iter->dictionary->head;
+  if (iter->dictionary->count == 0 || (const void *)iter->cursor >= iter->end) {
+    return NULL;
+  }
+  return iter->cursor;
+}
+
+Tuple *dict_read_next(DictionaryIterator *iter) {
+  RECORD_CALL();
+  iter->cursor = next_tuple(iter->cursor);
+  if ((const void *)iter->cursor >= iter->end) {
+    return NULL;
+  }
+  return iter->cursor;
+}
+
+Tuple *dict_find(const DictionaryIterator *iter, const uint32_t key) {
+  RECORD_CALL();
+  Tuple *tuple = iter->dictionary->head;
+  for (uint8_t i = 0; i < iter->dictionary->count && (const void *)tuple < iter->end; i++) {
+    if (tuple->key == key) {
+      return tuple;
+    }
+    tuple = next_tuple(tuple);
+  }
+  return NULL;
+}
+
+// AppMessage
+
+AppMessageInboxReceived app_message_register_inbox_received(AppMessageInboxReceived received_callback) {
+  RECORD_CALL();
+  AppMessageInboxReceived previous = s_inbox_received;
+  s_inbox_received = received_callback;
+  return previous;
+}
+
+AppMessageInboxDropped app_message_register_inbox_dropped(AppMessageInboxDropped dropped_callback) {
+  RECORD_CALL();
+  AppMessageInboxDropped previous = s_inbox_dropped;
+  s_inbox_dropped = dropped_callback;
+  return previous;
+}
+
+AppMessageOutboxSent app_message_register_outbox_sent(AppMessageOutboxSent sent_callback) {
+  RECORD_CALL();
+  AppMessageOutboxSent previous = s_outbox_sent;
+  s_outbox_sent = sent_callback;
+  return previous;
+}
+
+AppMessageOutboxFailed app_message_register_outbox_failed(AppMessageOutboxFailed failed_callback) {
+  RECORD_CALL();
+  AppMessageOutboxFailed previous = s_outbox_failed;
+  s_outbox_failed = failed_callback;
+  return previous;
+}
+
+AppMessageResult app_message_open(const uint32_t size_inbound, const uint32_t size_outbound) {
+  RECORD_CALL();
+  if (s_outbox) {
+    sim_error("app_message_open called twice");
+    return APP_MSG_INVALID_ARGS;
+  }
+  s_inbox_size = size_inbound;
+  s_outbox_size = size_outbound;
+  s_outbox = malloc(size_outbound);
+  return APP_MSG_OK;
+}
+
+AppMessageResult app_message_outbox_begin(DictionaryIterator **iterator) {
+  RECORD_CALL();
+  if (!s_outbox) {
+    return APP_MSG_INVALID_ARGS;
+  }
+  if (s_outbox_sending || s_outbox_building) {
+    return APP_MSG_BUSY;
+  }
+  dict_write_begin(&s_outbox_iter, s_outbox, (uint16_t)s_outbox_size);
+  s_outbox_building = true;
+  *iterator = &s_outbox_iter;
+  return APP_MSG_OK;
+}
+
+static void outbox_result(void *data, uint32_t size) {
+  DictionaryIterator iter;
+  dict_read_begin_from_buffer(&iter, data, (uint16_t)size);
+  s_outbox_sending = false;
+  if (s_connected) {
+    if (s_send_handler) {
+      s_send_handler(&iter);
+    }
+    if (s_outbox_sent) {
+      s_outbox_sent(&iter, NULL);
+    }
+  } else {
+    s_report.messages_failed++;
+    if (s_outbox_failed) {
+      s_outbox_failed(&iter, APP_MSG_NOT_CONNECTED, NULL);
+    }
+  }
+  free(data);
+}
+
+AppMessageResult app_message_outbox_send(void) {
+  RECORD_CALL();
+  if (!s_outbox_building) {
+    return APP_MSG_INVALID_ARGS;
+  }
+  s_outbox_building = false;
+  s_outbox_sending = true;
+  const uint32_t size = dict_size(&s_outbox_iter);
+  uint8_t *copy = malloc(size);
+  memcpy(copy, s_outbox, size);
+  s_report.messages_sent++;
+  s_report.message_bytes_sent += size;
+  schedule_event(SEND_LATENCY_MS, outbox_result, copy, size);
+  return APP_MSG_OK;
+}
+
+static void inbox_delivery(void *data, uint32_t size) {
+  if (!s_connected) {
+    // Lost on the way; the phone does not retry
+  } else if (!s_outbox || size > s_inbox_size) {
+    if (s_inbox_dropped) {
+      s_inbox_dropped(APP_MSG_BUFFER_OVERFLOW, NULL);
+    }
+  } else {
+    DictionaryIterator iter;
+    dict_read_begin_from_buffer(&iter, data, (uint16_t)size);
+    s_report.messages_received++;
+    s_report.message_bytes_received += size;
+    if (s_inbox_received) {
+      s_inbox_received(&iter, NULL);
+    }
+  }
+  free(data);
+}
+
+// AppSync keeps the values in its buffer and reports changed keys. It takes
+// over the inbox handler like the real one does.
+
+static void app_sync_inbox_received(DictionaryIterator *iterator, void *context) {
+  if (!s_sync) {
+    return;
+  }
+  for (Tuple *tuple = dict_read_first(iterator); tuple; tuple = dict_read_next(iterator)) {
+    Tuple *current = dict_find(&s_sync->current_iter, tuple->key);
+    if (!current) {
+      continue;
+    }
+    if (current->type != tuple->type || current->length != tuple->length) {
+      s_sync->error(DICT_INTERNAL_INCONSISTENCY, APP_MSG_OK, s_sync->context);
+      continue;
+    }
+    uint8_t old_value[TUPLE_HEADER_SIZE + 8];
+    const size_t old_size = TUPLE_HEADER_SIZE + (current->length < 8 ? current->length : 8);
+    memcpy(old_value, current, old_size);
+    memcpy(current->value, tuple->value, tuple->length);
+    s_sync->tuple_changed(tuple->key, current, (const Tuple *)old_value, s_sync->context);
+  }
+}
+
+void app_sync_init(AppSync *s, uint8_t *buffer, const uint16_t buffer_size, const Tuplet *const keys_and_initial_values,
+                   const uint8_t count, AppSyncTupleChangedCallback tuple_changed_callback,
+                   AppSyncErrorCallback error_callback, void *context) {
+  RECORD_CALL();
+  *s = (AppSync) {
+    .buffer = buffer, .buffer_size = buffer_size,
+    .tuple_changed = tuple_changed_callback, .error = error_callback, .context = context
+  };
+  dict_write_begin(&s->current_iter, buffer, buffer_size);
+  for (uint8_t i = 0; i < count; i++) {
+    const DictionaryResult result = dict_write_tuplet(&s->current_iter, &keys_and_initial_values[i]);
+    if (result != DICT_OK) {
+      error_callback(result, APP_MSG_OK, context);
+      return;
+    }
+  }
+  dict_write_end(&s->current_iter);
+  s_sync = s;
+  app_message_register_inbox_received(app_sync_inbox_received);
+
+  for (Tuple *tuple = dict_read_first(&s->current_iter); tuple; tuple = dict_read_next(&s->current_iter)) {
+    tuple_changed_callback(tuple->key, tuple, NULL, context);
+  }
+}
+
+void app_sync_deinit(AppSync *s) {
+  RECORD_CALL();
+  if (s_sync == s) {
+    s_sync = NULL;
+  }
+}
+
+// App lifecycle and worker
+
+AppLaunchReason launch_reason(void) {
+  RECORD_CALL();
+  return APP_LAUNCH_USER;
+}
+
+void app_event_loop(void) {
+  RECORD_CALL();
+  render();
+  if (s_event_loop) {
+    s_event_loop();
+  }
+}
+
+bool app_worker_is_running(void) {
+  RECORD_CALL();
+  return s_worker_running;
+}
+
+AppWorkerResult app_worker_launch(void) {
+  RECORD_CALL();
+  if (s_worker_running) {
+    return APP_WORKER_RESULT_ALREADY_RUNNING;
+  }
+  s_worker_running = true;
+  return APP_WORKER_RESULT_SUCCESS;
+}
+
+AppWorkerResult app_worker_kill(void) {
+  RECORD_CALL();
+  if (!s_worker_running) {
+    return APP_WORKER_RESULT_NOT_RUNNING;
+  }
+  s_worker_running = false;
+  return APP_WORKER_RESULT_SUCCESS;
+}
+
+bool app_worker_message_subscribe(AppWorkerMessageHandler handler) {
+  RECORD_CALL();
+  return true;
+}
+
+bool app_worker_message_unsubscribe(void) {
+  RECORD_CALL();
+  return true;
+}
+
+void app_worker_send_message(uint8_t type, AppWorkerMessage *data) {
+  RECORD_CALL();
+  if (s_worker_running) {
+    s_report.worker_messages++;
+  }
+}
+
+// Driver interface
+
+void sim_start(time_t start) {
+  s_start_ms = (int64_t)start * 1000;
+  s_now_ms = s_start_ms;
+}
+
+void sim_set_event_loop(void (*loop)(void)) {
+  s_event_loop = loop;
+}
+
+int64_t sim_now_ms(void) {
+  return s_now_ms;
+}
+
+void sim_set_trace(bool trace) {
+  s_trace = trace;
+}
+
+void sim_set_log(bool log) {
+  s_log = log;
+}
+
+void sim_set_send_handler(SimSendHandler handler) {
+  s_send_handler = handler;
+}
+
+typedef enum {
+  DUE_NOTHING = 0,
+  DUE_EVENT,
+  DUE_TIMER,
+  DUE_TICK,
+  DUE_FRAME
+} Due;
+
+// Advance to the earliest of everything pending. Equal times go in a fixed
+// order: runtime events, app timers (in registration order), ticks, frames.
+void sim_run_for(uint32_t ms) {
+  const int64_t target = s_now_ms + ms;
+  for (;;) {
+    SimEvent *event = NULL;
+    for (size_t i = 0; i < s_event_count; i++) {
+      if (!event || s_events[i].due_ms < event->due_ms
+          || (s_events[i].due_ms == event->due_ms && s_events[i].seq < event->seq)) {
+        event = &s_events[i];
+      }
+    }
+    AppTimer *timer = NULL;
+    for (size_t i = 0; i < s_timer_count; i++) {
+      if (!timer || s_timers[i]->due_ms < timer->due_ms
+          || (s_timers[i]->due_ms == timer->due_ms && s_timers[i]->seq < timer->seq)) {
+        timer = s_timers[i];
+      }
+    }
+
+    Due due = DUE_NOTHING;
+    int64_t next = target + 1;
+    if (event && event->due_ms < next) {
+      due = DUE_EVENT;
+      next = event->due_ms;
+    }
+    if (timer && timer->due_ms < next) {
+      due = DUE_TIMER;
+      next = timer->due_ms;
+    }
+    if (s_tick_handler && s_next_tick_ms >= 0 && s_next_tick_ms < next) {
+      due = DUE_TICK;
+      next = s_next_tick_ms;
+    }
+    if (s_animation_next_ms >= 0 && s_animation_next_ms < next) {
+      due = DUE_FRAME;
+      next = s_animation_next_ms;
+    }
+    if (due == DUE_NOTHING) {
+      break;
+    }
+
+    if (next > s_now_ms) {
+      s_now_ms = next;
+    }
+    switch (due) {
+      case DUE_EVENT: {
+        const SimEvent current = *event;
+        *event = s_events[--s_event_count];
+        current.handler(current.data, current.size);
+        break;
+      }
+      case DUE_TIMER:
+        fire_timer(timer);
+        break;
+      case DUE_TICK:
+        fire_tick();
+        break;
+      case DUE_FRAME:
+        animation_frame();
+        break;
+      case DUE_NOTHING:
+        break;
+    }
+    render();
+  }
+  s_now_ms = target;
+}
+
+void sim_set_battery(uint8_t percent, bool charging) {
+  s_battery = (BatteryChargeState) { .charge_percent = percent, .is_charging = charging, .is_plugged = charging };
+  if (s_battery_handler) {
+    s_battery_handler(s_battery);
+  }
+  render();
+}
+
+void sim_set_connected(bool connected) {
+  if (connected == s_connected) {
+    return;
+  }
+  s_connected = connected;
+  if (s_connection_handlers.pebble_app_connection_handler) {
+    s_connection_handlers.pebble_app_connection_handler(connected);
+  }
+  render();
+}
+
+void sim_tap(void) {
+  if (s_tap_handler) {
+    s_tap_handler(ACCEL_AXIS_Z, 1);
+  }
+  render();
+}
+
+bool sim_click(ButtonId button, bool long_press) {
+  ClickHandler handler = long_press ? s_long_click[button] : s_single_click[button];
+  if (!handler) {
+    return false;
+  }
+  handler(NULL, s_window);
+  render();
+  return true;
+}
+
+void sim_deliver(const uint8_t *dict, uint32_t size, uint32_t delay_ms) {
+  uint8_t *copy = malloc(size);
+  memcpy(copy, dict, size);
+  schedule_event(delay_ms, inbox_delivery, copy, size);
+}
+
+void sim_report(SimReport *report) {
+  *report = s_report;
+  report->elapsed_s = (uint32_t)((s_now_ms - s_start_ms) / 1000);
+}
+
+static int compare_calls(const void *a, const void *b) {
+  const CallSite *x = a;
+  const CallSite *y = b;
+  if (x->count != y->count) {
+    return x->count < y->count ? 1 : -1;
+  }
+  return strcmp(x->name, y->name);
+}
+
+void sim_print_calls(FILE *out) {
+  CallSite calls[MAX_CALL_SITES];
+  memcpy(calls, s_calls, s_call_count * sizeof(CallSite));
+  qsort(calls, s_call_count, sizeof(CallSite), compare_calls);
+  for (int i = 0; i < s_call_count; i++) {
+    fprintf(out, "  %8lu  %s\n", (unsigned long)calls[i].count, calls[i].name);
+  }
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <pebble.h>
+
+// Driver side of the fake runtime in pebble.c: moves the virtual clock,
+// plays the watch's surroundings and reads back what the face did.
+
+// Counters over a whole run; everything the face allocated is tracked by kind
+typedef enum {
+  SIM_LAYER = 0,
+  SIM_TEXT_LAYER,
+  SIM_WINDOW,
+  SIM_PROPERTY_ANIMATION,
+  SIM_APP_TIMER,
+  SIM_KINDS
+} SimKind;
+
+typedef struct {
+  uint32_t allocations[SIM_KINDS];
+  uint32_t frees[SIM_KINDS];
+  uint32_t live[SIM_KINDS];
+  size_t heap_peak;              // Bytes of live runtime objects at the high-water mark
+  uint32_t api_errors;           // Calls on destroyed objects, double subscriptions, ...
+
+  uint32_t frames;               // Screen renders
+  uint32_t layer_draws;          // Update procs run
+  uint32_t text_draws;           // Text layers drawn
+  uint32_t graphics_calls;       // graphics_* calls from update procs
+
+  uint32_t animations_scheduled;
+  uint32_t animations_finished;
+  uint32_t animations_cancelled; // Unscheduled before they finished
+
+  uint32_t timer_wakeups;        // App timers that fired
+  uint32_t ticks;                // Tick service calls
+
+  uint32_t messages_sent;
+  uint32_t message_bytes_sent;
+  uint32_t messages_failed;
+  uint32_t messages_received;
+  uint32_t message_bytes_received;
+
+  uint32_t persist_writes;
+  uint32_t persist_bytes_written;
+  uint32_t worker_messages;
+
+  uint32_t elapsed_s;            // Virtual time since sim_start
+} SimReport;
+
+// Called for every message the face sends that reached the phone
+typedef void (*SimSendHandler)(DictionaryIterator *message);
+
+// Set the virtual clock; call before the face starts
+void sim_start(time_t start);
+
+// What app_event_loop runs; returning from it ends the app
+void sim_set_event_loop(void (*loop)(void));
+
+// Virtual time in ms since the epoch
+int64_t sim_now_ms(void);
+
+// Advance the clock, running everything that comes due on the way
+void sim_run_for(uint32_t ms);
+
+void sim_set_battery(uint8_t percent, bool charging);
+void sim_set_connected(bool connected);
+void sim_tap(void);
+
+// Press a button; false if the face has no handler for it
+bool sim_click(ButtonId button, bool long_press);
+
+// Deliver a dictionary built with dict_write_begin to the face after delay_ms
+void sim_deliver(const uint8_t *dict, uint32_t size, uint32_t delay_ms);
+void sim_set_send_handler(SimSendHandler handler);
+
+// Print every runtime call as it happens
+void sim_set_trace(bool trace);
+
+// Print the face's APP_LOG output (off by default)
+void sim_set_log(bool log);
+
+void sim_report(SimReport *report);
+
+// Runtime calls made by the face, most frequent first
+void sim_print_calls(FILE *out);
+
+extern const char *const SIM_KIND_NAMES[SIM_KINDS];
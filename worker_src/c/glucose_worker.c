@@ -0,0 +1,57 @@
+#include <pebble_worker.h>
+
+#include "../../src/GlucoseWorker.h"
+
+static ReadingHistory s_history;
+
+static const StoredReading *latest_reading(void) {
+  return s_history.count > 0 ? &s_history.readings[s_history.count - 1] : NULL;
+}
+
+static void load_history(void) {
+  if (persist_read_data(PERSIST_KEY_WORKER_HISTORY, &s_history, sizeof(s_history)) != (int)sizeof(s_history)
+      || s_history.count > WORKER_HISTORY_SIZE) {
+    s_history.count = 0;
+  }
+}
+
+// Append a reading the face received from the phone; older or repeated ones are ignored
+static void add_reading(const StoredReading *reading) {
+  const StoredReading *latest = latest_reading();
+  if (reading->value <= 0 || (latest && reading->timestamp <= latest->timestamp)) {
+    return;
+  }
+
+  if (s_history.count == WORKER_HISTORY_SIZE) {
+    memmove(&s_history.readings[0], &s_history.readings[1],
+            (WORKER_HISTORY_SIZE - 1) * sizeof(StoredReading));
+    s_history.count--;
+  }
+  s_history.readings[s_history.count++] = *reading;
+  persist_write_data(PERSIST_KEY_WORKER_HISTORY, &s_history, sizeof(s_history));
+}
+
+// The face reads the history itself at launch; staleness is checked there
+static void app_message_handler(uint16_t type, AppWorkerMessage *message) {
+  if (type != WORKER_MSG_READING) {
+    return;
+  }
+  StoredReading reading;
+  worker_message_unpack(message, &reading);
+  add_reading(&reading);
+}
+
+static void worker_init(void) {
+  load_history();
+  app_worker_message_subscribe(app_message_handler);
+}
+
+static void worker_deinit(void) {
+  app_worker_message_unsubscribe();
+}
+
+int main(void) {
+  worker_init();
+  worker_event_loop();
+  worker_deinit();
+}